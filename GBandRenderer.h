@@ -0,0 +1,35 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GBANDRENDERER_H
+#define GBANDRENDERER_H
+
+#include "GPicture.h"
+#include "include/GPNGWriter.h"
+#include <functional>
+
+/**
+ * Receives the finished image one row at a time, top to bottom. Return false to stop rendering.
+ */
+using GBandRowProc = std::function<bool(int y, const GPixel row[], int width)>;
+
+/**
+ * Renders picture into a width x height image one horizontal band of bandHeight rows at a time,
+ * reusing a single band-sized bitmap, and hands each finished row to rowProc. Each band is a
+ * canvas that rasterizes as the full image would but only writes the band's rows, and draws that
+ * miss the band are skipped entirely. Memory is O(width * bandHeight) for any height, and the
+ * output is identical to a direct render.
+ *
+ * Returns false if rowProc stopped the render, or the band couldn't be allocated.
+ */
+bool GRenderBands(const GPicture& picture, int width, int height, int bandHeight,
+                  const GBandRowProc& rowProc);
+
+/**
+ * GRenderBands straight into a streaming PNG writer. Returns true if the file was written.
+ */
+bool GRenderBandsToPNG(const GPicture& picture, int width, int height, const char path[],
+                       int bandHeight = 256, const GPNGOptions& options = GPNGOptions());
+
+#endif //GBANDRENDERER_H
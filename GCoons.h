@@ -0,0 +1,32 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GCOONS_H
+#define GCOONS_H
+
+#include "include/GCanvas.h"
+#include "include/GMatrix.h"
+#include "include/GPaint.h"
+
+/*
+ * Quadratic Coons patch, control points laid out as in GFinal::drawQuadraticCoons:
+ *
+ *  pts[0]    pts[1]    pts[2]
+ *  pts[7]              pts[3]
+ *  pts[6]    pts[5]    pts[4]
+ */
+
+/**
+ * Returns the level (number of interior lines per side) needed so that the triangles stay within
+ * the flatness tolerance of the patch, given its control points in device space.
+ */
+int GCoonsLevel(const GPoint devicePts[8]);
+
+/**
+ * Evaluates the patch on a (level + 2) x (level + 2) grid with forward differencing, and draws it
+ * as one shared-vertex mesh. tex may be null.
+ */
+void GDrawCoonsMesh(GCanvas* canvas, const GPoint pts[8], const GPoint tex[4], int level, const GPaint& paint);
+
+#endif //GCOONS_H
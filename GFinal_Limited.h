@@ -10,6 +10,10 @@
 #include "GShader_Gradient2.h"
 #include "GShader_Voronoi.h"
 #include "GShader_PosGradient.h"
+#include "GShader_Sweep.h"
+#include "GShader_ColorMatrix.h"
+#include "GStroker.h"
+#include "GCoons.h"
 
 
 class GFinal_Limited : public GFinal {
@@ -28,7 +32,13 @@ public:
 
     virtual std::shared_ptr<GShader> createSweepGradient(GPoint center, float startRadians,
                                                          const GColor colors[], int count) {
-        return nullptr;
+        if (count < 1) {
+            return nullptr;
+        } else if (count == 1) {
+            return std::make_shared<GShader_Gradient1>(GPoint(), GPoint(), colors, count);
+        } else {
+            return std::make_shared<GShader_Sweep>(center, startRadians, colors, count);
+        }
     }
 
     virtual std::shared_ptr<GShader> createLinearPosGradient(GPoint p0, GPoint p1,
@@ -44,17 +54,25 @@ public:
         }
     }
 
-    virtual std::shared_ptr<GShader> createColorMatrixShader(const GColorMatrix&,
+    virtual std::shared_ptr<GShader> createColorMatrixShader(const GColorMatrix& colorMatrix,
                                                              GShader* realShader) {
-        return nullptr;
+        if (realShader == nullptr) {
+            return nullptr;
+        }
+        return std::make_shared<GShader_ColorMatrix>(colorMatrix, realShader);
     }
 
-    virtual std::shared_ptr<GPath> strokePolygon(const GPoint[], int count, float width, bool isClosed) {
-        return nullptr;
+    virtual std::shared_ptr<GPath> strokePolygon(const GPoint pts[], int count, float width, bool isClosed) {
+        return GStrokePolygon(pts, count, width, isClosed);
     }
 
-    virtual void drawQuadraticCoons(GCanvas*, const GPoint pts[8], const GPoint tex[4],
-                                    int level, const GPaint&) {}
+    virtual void drawQuadraticCoons(GCanvas* canvas, const GPoint pts[8], const GPoint tex[4],
+                                    int level, const GPaint& paint) {
+        // level is a floor: the patch's device-space curvature may ask for a finer mesh.
+        GPoint devicePts[8];
+        canvas->getTotalMatrix().mapPoints(devicePts, pts, 8);
+        GDrawCoonsMesh(canvas, pts, tex, std::max({level, GCoonsLevel(devicePts), 0}), paint);
+    }
 };
 
 
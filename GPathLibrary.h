@@ -0,0 +1,68 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GPATHLIBRARY_H
+#define GPATHLIBRARY_H
+
+#include "include/GPath.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * A versioned binary file of paths, laid out so that it can be mmap'ed and used in place:
+ *
+ *   Header   "GPLB", version, path count, byte-order mark                  16 bytes
+ *   Entries  per path: point offset, verb offset, point count, verb count,
+ *            bounds (left, top, right, bottom)                              40 bytes each
+ *   Points   each path's GPoints, 8-byte aligned
+ *   Verbs    each path's 1-byte GPathVerbs
+ *
+ * Offsets are from the start of the file. Values are stored in the writer's native order, and the
+ * byte-order mark (kByteOrderMark as written) lets a reader with the other order reject the file.
+ */
+class GPathLibrary {
+public:
+    static constexpr uint32_t kVersion = 2;
+    static constexpr uint32_t kByteOrderMark = 0x01020304;
+
+    /**
+     *  Serializes the paths into the library format.
+     */
+    static std::vector<uint8_t> Serialize(const std::vector<std::shared_ptr<GPath>>& paths);
+
+    /**
+     *  Writes Serialize(paths) to the file. Returns false if the file could not be written.
+     */
+    static bool Write(const char filename[], const std::vector<std::shared_ptr<GPath>>& paths);
+
+    /**
+     *  Maps the file read-only. Returns null if it can't be opened, or isn't a valid library.
+     */
+    static std::shared_ptr<GPathLibrary> Map(const char filename[]);
+
+    /**
+     *  Uses data (a serialized library, 8-byte aligned) in place; owner keeps it alive. Returns
+     *  null if any count, offset or verb doesn't fit in size bytes, or the byte order differs.
+     */
+    static std::shared_ptr<GPathLibrary> Make(const void* data, size_t size, std::shared_ptr<const void> owner);
+
+    int count() const { return fCount; }
+
+    /**
+     *  Returns a read-only path whose points and verbs point straight into the library's storage
+     *  (which the path keeps alive), with the stored bounds.
+     */
+    std::shared_ptr<GPath> path(int index) const;
+
+private:
+    GPathLibrary(const uint8_t* data, int count, std::shared_ptr<const void> owner)
+        : fData(data), fCount(count), fOwner(std::move(owner)) {}
+
+    const uint8_t*              fData;
+    int                         fCount;
+    std::shared_ptr<const void> fOwner;
+};
+
+#endif //GPATHLIBRARY_H
@@ -0,0 +1,80 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GPICTURE_H
+#define GPICTURE_H
+
+#include "include/GCanvas.h"
+#include "include/GMatrix.h"
+#include "include/GPaint.h"
+#include "include/GPath.h"
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+/*
+ * A recorded list of canvas calls that can be played back onto any canvas, any number of times.
+ * Each draw remembers the device rows it can touch, so playback can skip draws outside a band.
+ */
+class GPicture {
+public:
+    /**
+     *  Replays the calls onto canvas. Draws that can't reach device rows [top, bottom) (in the
+     *  recording's device space) are skipped; matrix and save/restore calls always run. Saves left
+     *  open by the recording are restored at the end.
+     */
+    void playback(GCanvas* canvas,
+                  float top = -std::numeric_limits<float>::infinity(),
+                  float bottom = std::numeric_limits<float>::infinity()) const;
+
+    int count() const { return (int) fOps.size(); }
+
+private:
+    friend class GRecordingCanvas;
+
+    struct Op {
+        float top, bottom;  // device rows touched (unbounded for state changes and clears)
+        std::function<void(GCanvas*)> proc;
+    };
+
+    std::vector<Op> fOps;
+    int             fOpenSaves = 0;
+};
+
+/*
+ * A canvas that records what is drawn into it instead of drawing.
+ */
+class GRecordingCanvas : public GCanvas {
+public:
+    GRecordingCanvas();
+
+    void save() override;
+    void restore() override;
+    void concat(const GMatrix&) override;
+    GMatrix getTotalMatrix() const override { return fMatrixStack.back(); }
+    void clear(const GColor&) override;
+    void drawRect(const GRect&, const GPaint&) override;
+    void drawConvexPolygon(const GPoint[], int count, const GPaint&) override;
+    void drawPath(const GPath&, const GPaint&) override;
+    void drawStrokePolygon(const GPoint[], int count, float width, bool isClosed, const GPaint&) override;
+    void drawMesh(const GPoint verts[], const GColor colors[], const GPoint texs[],
+                  int count, const int indices[], const GPaint&) override;
+    void drawQuad(const GPoint verts[4], const GColor colors[4], const GPoint texs[4],
+                  int level, const GPaint&) override;
+
+    /**
+     *  Returns everything recorded so far, and starts a new, empty recording.
+     */
+    std::shared_ptr<GPicture> finish();
+
+private:
+    std::shared_ptr<GPicture> fPicture;
+    std::vector<GMatrix>      fMatrixStack;  // to find each draw's device rows
+
+    void addState(std::function<void(GCanvas*)> proc);
+    void addDraw(const GPoint pts[], int count, std::function<void(GCanvas*)> proc);
+};
+
+#endif //GPICTURE_H
@@ -0,0 +1,66 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GPIXEL_OPS_H
+#define GPIXEL_OPS_H
+
+#include "include/GPixel.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+/*
+ * Returns round(x / 255) exactly for 0 <= x <= 255 * 255, without a division.
+ */
+static inline unsigned GDiv255(unsigned x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+/*
+ * Component-wise product of two premultiplied pixels: (p * q) / 255 per channel.
+ */
+static inline GPixel GPixel_Modulate(GPixel p, GPixel q) {
+  return GPixel_PackARGB(
+      GDiv255(GPixel_GetA(p) * GPixel_GetA(q)),
+      GDiv255(GPixel_GetR(p) * GPixel_GetR(q)),
+      GDiv255(GPixel_GetG(p) * GPixel_GetG(q)),
+      GDiv255(GPixel_GetB(p) * GPixel_GetB(q))
+  );
+}
+
+/*
+ * row[i] = GPixel_Modulate(src0[i], src1[i]) for i in [0, count).
+ * Note: row may alias src0 or src1 (each block is loaded before it is stored).
+ */
+static inline void GPixel_ModulateRow(const GPixel src0[], const GPixel src1[], int count, GPixel row[]) {
+  int i = 0;
+#if defined(__SSE2__)
+  // 4 pixels per iteration: widen to 16-bit lanes, multiply, then the same exact div255 as GDiv255.
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bias = _mm_set1_epi16(128);
+  for (; i + 4 <= count; i += 4) {
+    __m128i p = _mm_loadu_si128((const __m128i*) (src0 + i));
+    __m128i q = _mm_loadu_si128((const __m128i*) (src1 + i));
+
+    __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(p, zero), _mm_unpacklo_epi8(q, zero));
+    __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(p, zero), _mm_unpackhi_epi8(q, zero));
+    lo = _mm_add_epi16(lo, bias);
+    hi = _mm_add_epi16(hi, bias);
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+    _mm_storeu_si128((__m128i*) (row + i), _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; i < count; i++) {
+    row[i] = GPixel_Modulate(src0[i], src1[i]);
+  }
+}
+
+
+
+#endif //GPIXEL_OPS_H
@@ -3,6 +3,7 @@
  */
 
 #include "GShader_Bitmap.h"
+#include <cstring>
 
 
 bool GShader_Bitmap::isOpaque() {
@@ -164,15 +165,42 @@ void GShader_Bitmap::shadeRow_kMirror(float a, float b, float px, float py, int
   }
 }
 
+void GShader_Bitmap::shadeRow_translate(float px, float py, int count, GPixel row[]) {
+  /* Each step adds exactly 1 to px, so floor(px + i) = floor(px) + i: the row is a straight
+   * copy of the bitmap row, padded with its edge pixels where it is clamped.
+   */
+  int bmWidth = sBitmap.width();
+  int iy = (int) std::floor(fmin(fmax(py, 0.f), height - 1.f));
+  const GPixel* src = sBitmap.getAddr(0, iy);
+
+  float fx = std::floor(px);
+  int leftCount = (int) fmin(fmax(-fx, 0.f), (float) count);   // pixels left of the bitmap
+  int start = (int) fmin(fmax(fx, 0.f), (float) bmWidth);      // first column copied
+  int copyCount = std::min(count - leftCount, bmWidth - start);
+
+  for (int i = 0; i < leftCount; i++) {
+    row[i] = src[0];
+  }
+  memcpy(row + leftCount, src + start, copyCount * sizeof(GPixel));
+  for (int i = leftCount + copyCount; i < count; i++) {
+    row[i] = src[bmWidth - 1];
+  }
+}
+
 void GShader_Bitmap::shadeRow(int x, int y, int count, GPixel row[]) {
-  float a = invMatrix[0];
-  float b = invMatrix[1];
-  float px = a*(x + 0.5f) + invMatrix[2] * (y + 0.5f) + invMatrix[4];
-  float py = b*(x + 0.5f) + invMatrix[3] * (y + 0.5f) + invMatrix[5];
+  const GMatrix& inv = invMatrix;
+  float a = inv[0];
+  float b = inv[1];
+  float px = a*(x + 0.5f) + inv[2] * (y + 0.5f) + inv[4];
+  float py = b*(x + 0.5f) + inv[3] * (y + 0.5f) + inv[5];
 
   // Note: Currently, the only differences between each function is the clamp method.
   switch (tileMode) {
     case 0: // kClamp
+      if (inv.isTranslate()) {
+        shadeRow_translate(px, py, count, row);
+        break;
+      }
       shadeRow_kClamp(a, b, px, py, count, row);
       break;
     case 1: // kRepeat
@@ -12,7 +12,9 @@
 
 class GShader_Bitmap : public GShader {
 public:
-  GShader_Bitmap(const GBitmap& bitmap, const GMatrix& localMatrix, GTileMode tMode) : sBitmap(bitmap), shaderMatrix(localMatrix) {
+  GShader_Bitmap(const GBitmap& bitmap, const GMatrix& localMatrix, GTileMode tMode,
+                 std::shared_ptr<const GBitmap> owner = nullptr)
+      : sBitmap(bitmap), sOwner(std::move(owner)), shaderMatrix(localMatrix) {
     contextMatrix = GMatrix();
     invMatrix = *localMatrix.invert();
     width = (float) bitmap.width();
@@ -29,6 +31,7 @@ public:
 
 private:
   const GBitmap sBitmap;
+  const std::shared_ptr<const GBitmap> sOwner;  // keeps shared pixels alive, if any
   const GMatrix shaderMatrix;
   GMatrix contextMatrix;
   GMatrix invMatrix;
@@ -36,6 +39,7 @@ private:
   float height;
   int tileMode;
 
+  void shadeRow_translate(float px, float py, int count, GPixel row[]);  // kClamp, translate-only inverse
   void shadeRow_kClamp(float a, float b, float px, float py, int count, GPixel row[]);
   void shadeRow_kRepeat(float a, float b, float px, float py, int count, GPixel row[]);
   void shadeRow_kMirror(float a, float b, float px, float py, int count, GPixel row[]);
@@ -0,0 +1,216 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "GShader_ColorMatrix.h"
+#include "include/GPixelConvert.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+GColorMatrix GColorMatrix_Concat(const GColorMatrix& a, const GColorMatrix& b) {
+  // Element (row i, column j) lives at [j*4 + i]; the translate column is [16 + i].
+  GColorMatrix result;
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 4; j++) {
+      float sum = 0;
+      for (int k = 0; k < 4; k++) {
+        sum += a[k*4 + i] * b[j*4 + k];
+      }
+      result[j*4 + i] = sum;
+    }
+    float translate = a[16 + i];
+    for (int k = 0; k < 4; k++) {
+      translate += a[k*4 + i] * b[16 + k];
+    }
+    result[16 + i] = translate;
+  }
+  return result;
+}
+
+bool GColorMatrix_PreservesRange(const GColorMatrix& m) {
+  // The extremes of each (affine) row over the unit cube come from summing its positive / negative terms.
+  for (int i = 0; i < 4; i++) {
+    float low = m[16 + i];
+    float high = m[16 + i];
+    for (int j = 0; j < 4; j++) {
+      float coefficient = m[j*4 + i];
+      if (coefficient < 0) {
+        low += coefficient;
+      } else {
+        high += coefficient;
+      }
+    }
+    if (low < 0.f || high > 1.f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool alphaPassesThrough(const GColorMatrix& m) {
+  return m[3] == 0 && m[7] == 0 && m[11] == 0 && m[15] == 1 && m[19] == 0;
+}
+
+static bool isPerChannel(const GColorMatrix& m) {
+  // r, g, b may only read themselves (plus translate); alpha must pass through untouched.
+  return m[4] == 0 && m[8] == 0 && m[12] == 0 &&
+         m[1] == 0 && m[9] == 0 && m[13] == 0 &&
+         m[2] == 0 && m[6] == 0 && m[14] == 0 &&
+         alphaPassesThrough(m);
+}
+
+GShader_ColorMatrix::GShader_ColorMatrix(const GColorMatrix& colorMatrix, GShader* realShader) : matrix(colorMatrix) {
+  proxyShader = realShader;
+  GShader_ColorMatrix* inner = dynamic_cast<GShader_ColorMatrix*>(realShader);
+  if (inner != nullptr && GColorMatrix_PreservesRange(inner->matrix) && alphaPassesThrough(inner->matrix)) {
+    /* Folding skips the inner stage's clamp and its premul round trip. The clamp is a no-op when the
+     * inner output is always in range. The round trip is not when alpha changes (e.g. to 0, which
+     * zeroes rgb for the outer matrix), so alpha must pass through. What remains is the inner
+     * stage's 8-bit rounding, which the folded matrix doesn't repeat (results can differ by that).
+     */
+    matrix = GColorMatrix_Concat(colorMatrix, inner->matrix);
+    proxyShader = inner->proxyShader;
+    proxyOwner = inner->proxyOwner;
+  } else {
+    proxyOwner = realShader->weak_from_this().lock();
+  }
+
+  // Opaque if alpha passes through from an opaque shader, or alpha is always set to 1.
+  bool alphaIgnoresRGB = matrix[3] == 0 && matrix[7] == 0 && matrix[11] == 0;
+  opaque = alphaIgnoresRGB && ((matrix[15] == 1 && matrix[19] == 0 && proxyShader->isOpaque()) ||
+                               (matrix[15] == 0 && matrix[19] >= 1));
+
+  useTables = isPerChannel(matrix);
+  if (useTables) {
+    buildTables();
+  }
+}
+
+void GShader_ColorMatrix::buildTables() {
+  uint8_t* tables[3] = {tableR, tableG, tableB};
+  for (int c = 0; c < 3; c++) {
+    float scale = matrix[c*4 + c];
+    float translate = matrix[16 + c];
+    for (int v = 0; v < 256; v++) {
+      float newV = GPinToUnit(scale * (v / 255.f) + translate);
+      tables[c][v] = (uint8_t) GRoundToInt(newV * 255);
+    }
+  }
+}
+
+bool GShader_ColorMatrix::isOpaque() {
+  return opaque;
+}
+
+bool GShader_ColorMatrix::setContext(const GMatrix& ctm) {
+  return proxyShader->setContext(ctm);
+}
+
+void GShader_ColorMatrix::shadeRow_Tables(int count, GPixel row[]) {
+  // Unpremul --> table --> premul, in blocks through the shared bulk conversions
+  uint8_t rgba[4 * 64];
+  for (int start = 0; start < count; start += 64) {
+    int n = std::min(64, count - start);
+    GConvertPremulToRGBA(row + start, n, rgba);
+    for (int i = 0; i < n; i++) {
+      rgba[4*i + 0] = tableR[rgba[4*i + 0]];
+      rgba[4*i + 1] = tableG[rgba[4*i + 1]];
+      rgba[4*i + 2] = tableB[rgba[4*i + 2]];
+    }
+    GConvertRGBAToPremul(rgba, n, row + start);
+  }
+}
+
+/**
+ * Unpremul --> 4x5 matrix --> clamp --> premul for one pixel.
+ */
+static GPixel applyMatrix(const GColorMatrix& m, GPixel pixel) {
+  int a = GPixel_GetA(pixel);
+  float invA = (a == 0) ? 0.f : 1.f / a;
+  float r = GPixel_GetR(pixel) * invA;
+  float g = GPixel_GetG(pixel) * invA;
+  float b = GPixel_GetB(pixel) * invA;
+  float alpha = a / 255.f;
+
+  float newR = GPinToUnit(m[0]*r + m[4]*g + m[8]*b + m[12]*alpha + m[16]);
+  float newG = GPinToUnit(m[1]*r + m[5]*g + m[9]*b + m[13]*alpha + m[17]);
+  float newB = GPinToUnit(m[2]*r + m[6]*g + m[10]*b + m[14]*alpha + m[18]);
+  float newA = GPinToUnit(m[3]*r + m[7]*g + m[11]*b + m[15]*alpha + m[19]);
+
+  return GPixel_PackARGB(GRoundToInt(newA * 255),
+                         GRoundToInt(newR * newA * 255),
+                         GRoundToInt(newG * newA * 255),
+                         GRoundToInt(newB * newA * 255));
+}
+
+void GShader_ColorMatrix::shadeRow_Matrix(int count, GPixel row[]) {
+  int i = 0;
+#if defined(__SSE2__)
+  // 4 pixels per iteration, one channel per register (r = [r0 r1 r2 r3], ...)
+  const __m128i byteMask = _mm_set1_epi32(0xFF);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 v255 = _mm_set1_ps(255.f);
+  const __m128 inv255 = _mm_set1_ps(1.f / 255.f);
+  __m128 m[20];
+  for (int j = 0; j < 20; j++) {
+    m[j] = _mm_set1_ps(matrix[j]);
+  }
+
+  for (; i + 4 <= count; i += 4) {
+    __m128i pixels = _mm_loadu_si128((const __m128i*) (row + i));
+    __m128 a = _mm_cvtepi32_ps(_mm_srli_epi32(pixels, GPIXEL_SHIFT_A));
+    __m128 r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, GPIXEL_SHIFT_R), byteMask));
+    __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, GPIXEL_SHIFT_G), byteMask));
+    __m128 b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, GPIXEL_SHIFT_B), byteMask));
+
+    // Unpremul (a == 0 --> rgb of 0)
+    __m128 nonZero = _mm_cmpgt_ps(a, zero);
+    __m128 invA = _mm_and_ps(nonZero, _mm_div_ps(one, _mm_max_ps(a, one)));
+    r = _mm_mul_ps(r, invA);
+    g = _mm_mul_ps(g, invA);
+    b = _mm_mul_ps(b, invA);
+    a = _mm_mul_ps(a, inv255);
+
+    __m128 newR = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], r), _mm_mul_ps(m[4], g)),
+                             _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[8], b), _mm_mul_ps(m[12], a)), m[16]));
+    __m128 newG = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1], r), _mm_mul_ps(m[5], g)),
+                             _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[9], b), _mm_mul_ps(m[13], a)), m[17]));
+    __m128 newB = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2], r), _mm_mul_ps(m[6], g)),
+                             _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[10], b), _mm_mul_ps(m[14], a)), m[18]));
+    __m128 newA = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[3], r), _mm_mul_ps(m[7], g)),
+                             _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[11], b), _mm_mul_ps(m[15], a)), m[19]));
+
+    // Clamp, premul, and round (floor(x + 0.5) like GRoundToInt; all values are >= 0)
+    newA = _mm_mul_ps(_mm_min_ps(_mm_max_ps(newA, zero), one), v255);
+    newR = _mm_mul_ps(_mm_min_ps(_mm_max_ps(newR, zero), one), newA);
+    newG = _mm_mul_ps(_mm_min_ps(_mm_max_ps(newG, zero), one), newA);
+    newB = _mm_mul_ps(_mm_min_ps(_mm_max_ps(newB, zero), one), newA);
+    __m128i outA = _mm_cvttps_epi32(_mm_add_ps(newA, half));
+    __m128i outR = _mm_cvttps_epi32(_mm_add_ps(newR, half));
+    __m128i outG = _mm_cvttps_epi32(_mm_add_ps(newG, half));
+    __m128i outB = _mm_cvttps_epi32(_mm_add_ps(newB, half));
+
+    __m128i out = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(outA, GPIXEL_SHIFT_A), _mm_slli_epi32(outR, GPIXEL_SHIFT_R)),
+                               _mm_or_si128(_mm_slli_epi32(outG, GPIXEL_SHIFT_G), _mm_slli_epi32(outB, GPIXEL_SHIFT_B)));
+    _mm_storeu_si128((__m128i*) (row + i), out);
+  }
+#endif
+  for (; i < count; i++) {
+    row[i] = applyMatrix(matrix, row[i]);
+  }
+}
+
+void GShader_ColorMatrix::shadeRow(int x, int y, int count, GPixel row[]) {
+  // Shade in place: the real shader fills row, then it is transformed.
+  proxyShader->shadeRow(x, y, count, row);
+  if (useTables) {
+    shadeRow_Tables(count, row);
+  } else {
+    shadeRow_Matrix(count, row);
+  }
+}
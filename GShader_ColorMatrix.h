@@ -0,0 +1,59 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GSHADER_COLORMATRIX_H
+#define GSHADER_COLORMATRIX_H
+
+#include "include/GShader.h"
+#include "include/GMatrix.h"
+#include "include/GFinal.h"
+
+
+class GShader_ColorMatrix : public GShader {
+public:
+  /**
+   * Note: if realShader is itself a GShader_ColorMatrix whose output never needs clamping and
+   *       whose alpha passes through, the two matrices are folded into one and this shader proxies
+   *       to the inner real shader (skipping the inner stage's 8-bit rounding).
+   */
+  GShader_ColorMatrix(const GColorMatrix& colorMatrix, GShader* realShader);
+
+  virtual bool isOpaque() override;
+
+  // Returns false if the inverse matrix does not exist
+  virtual bool setContext(const GMatrix& ctm) override;
+
+  virtual void shadeRow(int x, int y, int count, GPixel row[]) override;
+
+private:
+  GColorMatrix matrix;
+  GShader* proxyShader;
+  std::shared_ptr<GShader> proxyOwner;  // keeps proxyShader alive when it is shared-owned
+  bool opaque;
+
+  // Per-channel lookup tables (unpremul byte --> unpremul byte), used when r, g, b each only
+  // depend on themselves and alpha passes through.
+  bool useTables;
+  uint8_t tableR[256];
+  uint8_t tableG[256];
+  uint8_t tableB[256];
+
+  void buildTables();
+  void shadeRow_Tables(int count, GPixel row[]);
+  void shadeRow_Matrix(int count, GPixel row[]);
+};
+
+/**
+ * Returns a * b: applying the result is the same as applying b, then a (without clamping in between).
+ */
+GColorMatrix GColorMatrix_Concat(const GColorMatrix& a, const GColorMatrix& b);
+
+/**
+ * True if the matrix maps every color in [0, 1] to [0, 1], i.e. its output never needs clamping.
+ */
+bool GColorMatrix_PreservesRange(const GColorMatrix& m);
+
+
+
+#endif //GSHADER_COLORMATRIX_H
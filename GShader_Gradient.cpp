@@ -3,6 +3,7 @@
  */
 
 #include "GShader_Gradient.h"
+#include <algorithm>
 
 bool GShader_Gradient::isOpaque() {
   return opaque;
@@ -24,10 +25,11 @@ bool GShader_Gradient::setContext(const GMatrix& ctm) {
 }
 
 void GShader_Gradient::shadeRow_kClamp(float x_f, float y_f, int count, GPixel row[]) {
+  const GMatrix& inv = invMatrix;
   if (opaque) {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp and Scale
       px = fmin(fmax(px, 0.f), 0.9999f) * k;
       // Determine C0's index and distance from px
@@ -48,7 +50,7 @@ void GShader_Gradient::shadeRow_kClamp(float x_f, float y_f, int count, GPixel r
   } else {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp and Scale
       px = fmin(fmax(px, 0.f), 0.9999f) * k;
       // Determine C0's index and distance from px
@@ -71,10 +73,11 @@ void GShader_Gradient::shadeRow_kClamp(float x_f, float y_f, int count, GPixel r
 }
 
 void GShader_Gradient::shadeRow_kRepeat(float x_f, float y_f, int count, GPixel row[]) {
+  const GMatrix& inv = invMatrix;
   if (opaque) {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp and Scale
       px = fmodf(px, 1.f);
       if (px < 0.f) {
@@ -99,7 +102,7 @@ void GShader_Gradient::shadeRow_kRepeat(float x_f, float y_f, int count, GPixel
   } else {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp and Scale
       px = fmodf(px, 1.f);
       if (px < 0.f) {
@@ -126,10 +129,11 @@ void GShader_Gradient::shadeRow_kRepeat(float x_f, float y_f, int count, GPixel
 }
 
 void GShader_Gradient::shadeRow_kMirror(float x_f, float y_f, int count, GPixel row[]) {
+  const GMatrix& inv = invMatrix;
   if (opaque) {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp. If the iteration is odd, invert px.
       float floorx = std::floor(px);
       px = px - floorx;
@@ -158,7 +162,7 @@ void GShader_Gradient::shadeRow_kMirror(float x_f, float y_f, int count, GPixel
   } else {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp. If the iteration is odd, invert px.
       float floorx = std::floor(px);
       px = px - floorx;
@@ -188,6 +192,14 @@ void GShader_Gradient::shadeRow_kMirror(float x_f, float y_f, int count, GPixel
 
 
 void GShader_Gradient::shadeRow(int x, int y, int count, GPixel row[]) {
+  const GMatrix& inv = invMatrix;
+  // Gradient perpendicular to the row (no x term in the inverse): one color for the whole row.
+  if (inv[0] == 0.f && count > 1) {
+    shadeRow(x, y, 1, row);
+    std::fill(row + 1, row + count, row[0]);
+    return;
+  }
+
   float x_f = x + 0.5f;
   float y_f = y + 0.5f;
 
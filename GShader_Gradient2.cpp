@@ -3,6 +3,7 @@
  */
 
 #include "GShader_Gradient2.h"
+#include <algorithm>
 
 bool GShader_Gradient2::isOpaque() {
   return opaque;
@@ -24,11 +25,12 @@ bool GShader_Gradient2::setContext(const GMatrix& ctm) {
 }
 
 void GShader_Gradient2::shadeRow_kClamp(float x_f, float y_f, int count, GPixel row[]) {
+  const GMatrix& inv = invMatrix;
   // tileMode if-then
   if (opaque) {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp
       px = fmin(fmax(px, 0.f), 0.9999f);
       // Color Calculation
@@ -45,7 +47,7 @@ void GShader_Gradient2::shadeRow_kClamp(float x_f, float y_f, int count, GPixel
   } else {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp
       px = fmin(fmax(px, 0.f), 0.9999f);
       // Color Calculation
@@ -64,11 +66,12 @@ void GShader_Gradient2::shadeRow_kClamp(float x_f, float y_f, int count, GPixel
 }
 
 void GShader_Gradient2::shadeRow_kRepeat(float x_f, float y_f, int count, GPixel row[]) {
+  const GMatrix& inv = invMatrix;
   // tileMode if-then
   if (opaque) {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp
       px = abs(fmodf(px, 1.f));
       // Color Calculation
@@ -85,7 +88,7 @@ void GShader_Gradient2::shadeRow_kRepeat(float x_f, float y_f, int count, GPixel
   } else {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp
       px = abs(fmodf(px, 1.f));
       // Color Calculation
@@ -104,11 +107,12 @@ void GShader_Gradient2::shadeRow_kRepeat(float x_f, float y_f, int count, GPixel
 }
 
 void GShader_Gradient2::shadeRow_kMirror(float x_f, float y_f, int count, GPixel row[]) {
+  const GMatrix& inv = invMatrix;
   // tileMode if-then
   if (opaque) {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp. If the iteration is odd, invert px.
       float floorx = std::floor(px);
       px = px - floorx;
@@ -129,7 +133,7 @@ void GShader_Gradient2::shadeRow_kMirror(float x_f, float y_f, int count, GPixel
   } else {
     for (int i = 0; i < count; i++) {
       // Convert to [0, 1) gradient plane
-      float px = invMatrix[0]*x_f + invMatrix[2]*y_f + invMatrix[4];
+      float px = inv[0]*x_f + inv[2]*y_f + inv[4];
       // Clamp. If the iteration is odd, invert px.
       float floorx = std::floor(px);
       px = px - floorx;
@@ -152,6 +156,14 @@ void GShader_Gradient2::shadeRow_kMirror(float x_f, float y_f, int count, GPixel
 }
 
 void GShader_Gradient2::shadeRow(int x, int y, int count, GPixel row[]) {
+  const GMatrix& inv = invMatrix;
+  // Gradient perpendicular to the row (no x term in the inverse): one color for the whole row.
+  if (inv[0] == 0.f && count > 1) {
+    shadeRow(x, y, 1, row);
+    std::fill(row + 1, row + count, row[0]);
+    return;
+  }
+
   float x_f = x + 0.5f;
   float y_f = y + 0.5f;
 
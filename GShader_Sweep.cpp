@@ -0,0 +1,154 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "GShader_Sweep.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Polynomial atan(a) for a in [0, 1]; max error is under 2e-6 radians (float evaluation included),
+// far below one table step (~6e-3).
+static const float kAtanC0 = 0.99997726f;
+static const float kAtanC1 = -0.33262347f;
+static const float kAtanC2 = 0.19354346f;
+static const float kAtanC3 = -0.11643287f;
+static const float kAtanC4 = 0.05265332f;
+static const float kAtanC5 = -0.01172120f;
+
+static const float kRadiansToIndex = GShader_Sweep::kTableSize / (2.f * gFloatPI);
+
+/**
+ * Returns the table index for the angle of (u, v), measured from +x in [0, 2pi).
+ */
+static inline int sweepIndex(float u, float v) {
+  float absU = fabsf(u);
+  float absV = fabsf(v);
+  float maxUV = std::max(std::max(absU, absV), 1e-20f);
+  float a = std::min(absU, absV) / maxUV;
+  float s = a * a;
+  float r = (((((kAtanC5*s + kAtanC4)*s + kAtanC3)*s + kAtanC2)*s + kAtanC1)*s + kAtanC0) * a;
+
+  // Unfold the octant
+  if (absV > absU) {
+    r = gFloatPI/2 - r;
+  }
+  if (u < 0.f) {
+    r = gFloatPI - r;
+  }
+  if (v < 0.f) {
+    r = 2.f*gFloatPI - r;
+  }
+  return std::min((int) (r * kRadiansToIndex), GShader_Sweep::kTableSize - 1);
+}
+
+void GShader_Sweep::buildTable(const GColor colors[], int count) {
+  // Colors are evenly spaced over the turn: colors[0] at 0, colors[count-1] at 2pi.
+  float k = (float) (count - 1);
+  for (int i = 0; i < kTableSize; i++) {
+    // Sample the center of each table step
+    float px = ((i + 0.5f) / kTableSize) * k;
+    int C_index = std::min((int) px, count - 2);
+    float t = px - C_index;
+    GColor newColor = colors[C_index] + (colors[C_index + 1] - colors[C_index])*t;
+    newColor = newColor.pinToUnit();
+    // GColor --> GPixel
+    int a = (int) std::round(newColor.a * 255);
+    int r = (int) std::round(newColor.r * 255 * newColor.a);
+    int g = (int) std::round(newColor.g * 255 * newColor.a);
+    int b = (int) std::round(newColor.b * 255 * newColor.a);
+    table[i] = GPixel_PackARGB(a, r, g, b);
+  }
+}
+
+bool GShader_Sweep::isOpaque() {
+  return opaque;
+}
+
+bool GShader_Sweep::setContext(const GMatrix& ctm) {
+  if (contextMatrix == ctm) {
+    return true;
+  }
+
+  nonstd::optional<GMatrix> invCTMPointer = ctm.invert();
+
+  if (invCTMPointer.has_value()) {
+    contextMatrix = ctm;
+    invMatrix = shaderMatrix * *invCTMPointer;
+    return true;
+  }
+  return false;
+}
+
+void GShader_Sweep::shadeRow(int x, int y, int count, GPixel row[]) {
+  const GMatrix& inv = invMatrix;
+  float du = inv[0];
+  float dv = inv[1];
+  float u = du*(x + 0.5f) + inv[2] * (y + 0.5f) + inv[4];
+  float v = dv*(x + 0.5f) + inv[3] * (y + 0.5f) + inv[5];
+
+  int i = 0;
+#if defined(__SSE2__)
+  // Same math as sweepIndex(), 4 pixels per iteration; the octant unfolding is done with masks.
+  const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  const __m128 tiny = _mm_set1_ps(1e-20f);
+  const __m128 halfPI = _mm_set1_ps(gFloatPI/2);
+  const __m128 PI = _mm_set1_ps(gFloatPI);
+  const __m128 twoPI = _mm_set1_ps(2.f*gFloatPI);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 toIndex = _mm_set1_ps(kRadiansToIndex);
+  const __m128i maxIndex = _mm_set1_epi32(kTableSize - 1);
+
+  __m128 lane = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+  __m128 vu = _mm_add_ps(_mm_set1_ps(u), _mm_mul_ps(lane, _mm_set1_ps(du)));
+  __m128 vv = _mm_add_ps(_mm_set1_ps(v), _mm_mul_ps(lane, _mm_set1_ps(dv)));
+  const __m128 stepU = _mm_set1_ps(4.f*du);
+  const __m128 stepV = _mm_set1_ps(4.f*dv);
+
+  for (; i + 4 <= count; i += 4) {
+    __m128 absU = _mm_and_ps(vu, signMask);
+    __m128 absV = _mm_and_ps(vv, signMask);
+    __m128 maxUV = _mm_max_ps(_mm_max_ps(absU, absV), tiny);
+    __m128 a = _mm_div_ps(_mm_min_ps(absU, absV), maxUV);
+    __m128 s = _mm_mul_ps(a, a);
+
+    __m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kAtanC5), s), _mm_set1_ps(kAtanC4));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(kAtanC3));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(kAtanC2));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(kAtanC1));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(kAtanC0));
+    r = _mm_mul_ps(r, a);
+
+    __m128 mask = _mm_cmpgt_ps(absV, absU);
+    r = _mm_or_ps(_mm_and_ps(mask, _mm_sub_ps(halfPI, r)), _mm_andnot_ps(mask, r));
+    mask = _mm_cmplt_ps(vu, zero);
+    r = _mm_or_ps(_mm_and_ps(mask, _mm_sub_ps(PI, r)), _mm_andnot_ps(mask, r));
+    mask = _mm_cmplt_ps(vv, zero);
+    r = _mm_or_ps(_mm_and_ps(mask, _mm_sub_ps(twoPI, r)), _mm_andnot_ps(mask, r));
+
+    // Truncate to an index, and pin the index at 2pi back into the table
+    __m128i index = _mm_cvttps_epi32(_mm_mul_ps(r, toIndex));
+    __m128i over = _mm_cmpgt_epi32(index, maxIndex);
+    index = _mm_or_si128(_mm_and_si128(over, maxIndex), _mm_andnot_si128(over, index));
+
+    alignas(16) int indices[4];
+    _mm_store_si128((__m128i*) indices, index);
+    row[i] = table[indices[0]];
+    row[i + 1] = table[indices[1]];
+    row[i + 2] = table[indices[2]];
+    row[i + 3] = table[indices[3]];
+
+    vu = _mm_add_ps(vu, stepU);
+    vv = _mm_add_ps(vv, stepV);
+  }
+  u += i*du;
+  v += i*dv;
+#endif
+
+  for (; i < count; i++) {
+    row[i] = table[sweepIndex(u, v)];
+    u += du;
+    v += dv;
+  }
+}
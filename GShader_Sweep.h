@@ -0,0 +1,57 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GSHADER_SWEEP_H
+#define GSHADER_SWEEP_H
+
+#include "include/GShader.h"
+#include "include/GMatrix.h"
+
+
+class GShader_Sweep : public GShader {
+public:
+  // Number of entries in the premultiplied color table (one entry per 1/kTableSize of a turn).
+  enum {
+    kTableSize = 1024
+  };
+
+  GShader_Sweep(GPoint center, float startRadians, const GColor colors[], int count) {
+    shaderMatrix = getShaderMatrix(center, startRadians);
+    contextMatrix = GMatrix();
+    invMatrix = shaderMatrix;
+    opaque = true;
+    for (int i = 0; i < count; i++) {
+      if (colors[i].a < 0.9981f) {
+        opaque = false;
+      }
+    }
+    buildTable(colors, count);
+  }
+
+  virtual bool isOpaque() override;
+
+  // Returns false if the inverse matrix does not exist
+  virtual bool setContext(const GMatrix& ctm) override;
+
+  virtual void shadeRow(int x, int y, int count, GPixel row[]) override;
+
+private:
+  GMatrix shaderMatrix;
+  GMatrix contextMatrix;
+  GMatrix invMatrix;
+  GPixel table[kTableSize];
+  bool opaque;
+
+  // Maps device space --> sweep space, where the sweep starts along +x (startRadians is folded in here).
+  GMatrix getShaderMatrix(GPoint center, float startRadians) {
+    GMatrix matrix = GMatrix::Translate(center.x, center.y) * GMatrix::Rotate(startRadians);
+    return *matrix.invert();
+  }
+
+  void buildTable(const GColor colors[], int count);
+};
+
+
+
+#endif //GSHADER_SWEEP_H
@@ -6,13 +6,17 @@
 #define GSHADER_TRICOMPOSE_H
 
 #include "include/GShader.h"
+#include "GPixel_Ops.h"
 
 
 class GShader_TriCompose : public GShader {
 public:
-  GShader_TriCompose(GShader* gradientShader, GShader* stickingShader) {
+  // Note: scratch (if provided) is a reusable row buffer owned by the caller (e.g. the canvas),
+  //       so that shading does not need a new buffer per row. Otherwise, the shader owns one.
+  GShader_TriCompose(GShader* gradientShader, GShader* stickingShader, std::vector<GPixel>* scratch = nullptr) {
     gradShader = gradientShader;
     stickShader = stickingShader;
+    scratchRow = (scratch != nullptr) ? scratch : &ownedRow;
   }
 
   virtual bool isOpaque() {
@@ -29,37 +33,23 @@ public:
       return;
     }
 
-    GPixel gradRow[count], stickRow[count];
-    gradShader->shadeRow(x, y, count, gradRow);
-    stickShader->shadeRow(x, y, count, stickRow);
-    if (isOpaque()) {
-      for (int i = 0; i < count; i++) {
-        GPixel gradPixel = gradRow[i];
-        GPixel stickPixel = stickRow[i];
-        row[i] = GPixel_PackARGB(
-            255,
-            (int) std::round(((float) GPixel_GetR(gradPixel) * GPixel_GetR(stickPixel)) / 255.f),
-            (int) std::round(((float) GPixel_GetG(gradPixel) * GPixel_GetG(stickPixel)) / 255.f),
-            (int) std::round(((float) GPixel_GetB(gradPixel) * GPixel_GetB(stickPixel)) / 255.f)
-        );
-      }
-    } else {
-      for (int i = 0; i < count; i++) {
-        GPixel gradPixel = gradRow[i];
-        GPixel stickPixel = stickRow[i];
-        row[i] = GPixel_PackARGB(
-            (int) std::round(((float) GPixel_GetA(gradPixel) * GPixel_GetA(stickPixel)) / 255.f),
-            (int) std::round(((float) GPixel_GetR(gradPixel) * GPixel_GetR(stickPixel)) / 255.f),
-            (int) std::round(((float) GPixel_GetG(gradPixel) * GPixel_GetG(stickPixel)) / 255.f),
-            (int) std::round(((float) GPixel_GetB(gradPixel) * GPixel_GetB(stickPixel)) / 255.f)
-        );
-      }
+    // The gradient is shaded straight into row; only the texture needs the scratch buffer.
+    if ((int) scratchRow->size() < count) {
+      scratchRow->resize(count);
     }
+    GPixel* stickRow = scratchRow->data();
+    gradShader->shadeRow(x, y, count, row);
+    stickShader->shadeRow(x, y, count, stickRow);
+
+    // Note: if both are opaque, 255 * 255 / 255 keeps alpha at 255, so no special case is needed.
+    GPixel_ModulateRow(row, stickRow, count, row);
   }
 
 private:
   GShader* gradShader;
   GShader* stickShader;
+  std::vector<GPixel>* scratchRow;
+  std::vector<GPixel> ownedRow;
 };
 
 
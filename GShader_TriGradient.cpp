@@ -24,14 +24,15 @@ bool GShader_TriGradient::setContext(const GMatrix& ctm) {
 }
 
 void GShader_TriGradient::shadeRow(int x, int y, int count, GPixel row[]) {
+  const GMatrix& inv = invMatrix;
   // Note: Assumes that px and py are always within the (0, 1) right triangle.
   float x_f = x + 0.5f;
   float y_f = y + 0.5f;
 
-  float dx = invMatrix[0];
-  float dy = invMatrix[1];
-  float ix = dx*x_f + invMatrix[2]*y_f + invMatrix[4];
-  float iy = dy*x_f + invMatrix[3]*y_f + invMatrix[5];
+  float dx = inv[0];
+  float dy = inv[1];
+  float ix = dx*x_f + inv[2]*y_f + inv[4];
+  float iy = dy*x_f + inv[3]*y_f + inv[5];
   GColor newColor = dColor0 * ix + dColor1 * iy + color2;
   GColor dColor = dColor0 * dx + dColor1 * dy;
 
@@ -0,0 +1,45 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GSTROKER_H
+#define GSTROKER_H
+
+#include "include/GPath.h"
+#include "include/GPathBuilder.h"
+
+/**
+ * Receives a stroke outline as it is generated: contours of lines and quadratic arcs, each
+ * started by moveTo() and implicitly closed.
+ */
+class GStrokeSink {
+public:
+    virtual ~GStrokeSink() {}
+
+    // A hint for how many more points and verbs are coming.
+    virtual void reserve(int extraPoints, int extraVerbs) {}
+
+    virtual void moveTo(GPoint) = 0;
+    virtual void lineTo(GPoint) = 0;
+    virtual void quadTo(GPoint, GPoint) = 0;
+};
+
+/**
+ * Generates the outline of the stroke of a polygon, with round joins and caps: one contour around
+ * an open polygon, or an outer and an inner contour around a closed one. Inner joins pass through
+ * the vertex, and a full disk is added at vertices next to a segment shorter than the radius (where
+ * the outline alone would leave a notch), so the stroke fills correctly with non-zero winding.
+ *
+ * unitsPerPixel is how many outline units make one device pixel; the arcs are split finely enough to
+ * stay within a tenth of a pixel of the circle.
+ */
+void GStrokeOutline(const GPoint pts[], int count, float width, bool isClosed, float unitsPerPixel,
+                    GStrokeSink* sink);
+
+/**
+ * GStrokeOutline() as a path. The device scale isn't known here, so arcs are fit as if one path unit
+ * were one pixel, and never use fewer than 8 per circle.
+ */
+std::shared_ptr<GPath> GStrokePolygon(const GPoint pts[], int count, float width, bool isClosed);
+
+#endif //GSTROKER_H
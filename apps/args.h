@@ -0,0 +1,28 @@
+/**
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef G_args_DEFINED
+#define G_args_DEFINED
+
+#include <string.h>
+#include <string>
+
+/*
+ *  Returns true if arg is --name, or -n where n is name's first letter.
+ */
+inline bool is_arg(const char arg[], const char name[]) {
+    std::string str("--");
+    str += name;
+    if (!strcmp(arg, str.c_str())) {
+        return true;
+    }
+
+    char shortVers[3];
+    shortVers[0] = '-';
+    shortVers[1] = name[0];
+    shortVers[2] = 0;
+    return !strcmp(arg, shortVers);
+}
+
+#endif
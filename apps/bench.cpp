@@ -0,0 +1,188 @@
+/**
+ *  Copyright 2024 Christine Hu
+ *
+ *  Times every GDrawRec, plus synthetic scenes that stress one part of the canvas each.
+ *
+ *  bench [--match substr] [--repeat N] [--warmup N]
+ */
+
+#include "args.h"
+#include "image.h"
+#include "../include/GCanvas.h"
+#include "../include/GBitmap.h"
+#include "../include/GPaint.h"
+#include "../include/GPathBuilder.h"
+#include "../include/GRandom.h"
+#include "../include/GShader.h"
+#include "../include/GTime.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static void bench_clear(GCanvas* canvas) {
+    canvas->clear({0.25f, 0.5f, 0.75f, 1});
+}
+
+// Opaque and translucent solid rects: the blend loops without any shader or edge work
+static void bench_rects(GCanvas* canvas) {
+    GRandom rand;
+    for (int i = 0; i < 200; ++i) {
+        GRect r = GRect::XYWH(rand.nextF() * 768, rand.nextF() * 768, 256, 256);
+        GColor c = {rand.nextF(), rand.nextF(), rand.nextF(), (i & 1) ? 1.0f : 0.5f};
+        canvas->drawRect(r, GPaint(c));
+    }
+}
+
+// Convex polygons: edge building and span filling
+static void bench_polygons(GCanvas* canvas) {
+    GRandom rand;
+    for (int i = 0; i < 500; ++i) {
+        float cx = rand.nextF() * 1024, cy = rand.nextF() * 1024, r = 20 + rand.nextF() * 100;
+        GPoint pts[8];
+        for (int k = 0; k < 8; ++k) {
+            float angle = k * 2 * 3.14159265f / 8;
+            pts[k] = {cx + r * cosf(angle), cy + r * sinf(angle)};
+        }
+        canvas->drawConvexPolygon(pts, 8, GPaint(GColor{rand.nextF(), rand.nextF(), 0.5f, 0.75f}));
+    }
+}
+
+// Curved paths through the general (winding) scan converter
+static void bench_paths(GCanvas* canvas) {
+    GRandom rand;
+    GPathBuilder bu;
+    for (int i = 0; i < 100; ++i) {
+        bu.addCircle({rand.nextF() * 1024, rand.nextF() * 1024}, 10 + rand.nextF() * 80,
+                     (i & 1) ? GPathDirection::kCW : GPathDirection::kCCW);
+    }
+    auto path = bu.detach();
+    canvas->drawPath(*path, GPaint(GColor{0.2f, 0.6f, 0.3f, 0.8f}));
+}
+
+// Full-canvas gradients, straight and rotated
+static void bench_gradients(GCanvas* canvas) {
+    const GColor colors[] = {{1, 0, 0, 1}, {0, 1, 0, 0.5f}, {0, 0, 1, 1}, {1, 1, 0, 1}};
+    GPaint paint(GCreateLinearGradient({0, 0}, {1024, 300}, colors, 4, GTileMode::kMirror));
+    canvas->drawRect(GRect::WH(1024, 1024), paint);
+    canvas->rotate(0.3f);
+    canvas->drawRect(GRect::XYWH(100, -200, 800, 800), paint);
+}
+
+// Bitmap shader under scale and rotation, each tile mode
+static void bench_bitmaps(GCanvas* canvas) {
+    GBitmap bm;
+    bm.alloc(64, 64);
+    for (int y = 0; y < 64; ++y) {
+        for (int x = 0; x < 64; ++x) {
+            *bm.getAddr(x, y) = ((x ^ y) & 8) ? GPixel_PackARGB(0xFF, 0xFF, 0x80, 0) : GPixel_PackARGB(0xFF, 0, 0x40, 0xC0);
+        }
+    }
+    bm.setIsOpaque(GBitmap::kYes_IsOpaque);
+
+    const GTileMode modes[] = {GTileMode::kClamp, GTileMode::kRepeat, GTileMode::kMirror};
+    for (int i = 0; i < 3; ++i) {
+        GPaint paint(GCreateBitmapShader(bm, GMatrix::Scale(3, 2), modes[i]));
+        canvas->save();
+        canvas->translate(512, 512);
+        canvas->rotate(i * 0.4f);
+        canvas->drawRect(GRect::XYWH(-500, -500, 1000, 1000), paint);
+        canvas->restore();
+    }
+    free(bm.pixels());
+}
+
+// Color-interpolated triangle meshes and quads
+static void bench_meshes(GCanvas* canvas) {
+    const int N = 32;
+    std::vector<GPoint> verts;
+    std::vector<GColor> colors;
+    std::vector<int> indices;
+    for (int y = 0; y <= N; ++y) {
+        for (int x = 0; x <= N; ++x) {
+            verts.push_back({x * 1024.0f / N, y * 1024.0f / N});
+            colors.push_back({x / (float)N, y / (float)N, 0.5f, 1});
+        }
+    }
+    for (int y = 0; y < N; ++y) {
+        for (int x = 0; x < N; ++x) {
+            int i = y * (N + 1) + x;
+            indices.insert(indices.end(), {i, i + 1, i + N + 1, i + 1, i + N + 2, i + N + 1});
+        }
+    }
+    canvas->drawMesh(verts.data(), colors.data(), nullptr, 2 * N * N, indices.data(), GPaint());
+
+    const GPoint quad[] = {{100, 100}, {900, 50}, {1000, 900}, {50, 1000}};
+    const GColor quadColors[] = {{1, 0, 0, 0.5f}, {0, 1, 0, 0.5f}, {0, 0, 1, 0.5f}, {1, 1, 1, 0.5f}};
+    canvas->drawQuad(quad, quadColors, nullptr, 16, GPaint());
+}
+
+static const GDrawRec gBenchRecs[] = {
+    { bench_clear,     1024, 1024, "bench_clear",     0 },
+    { bench_rects,     1024, 1024, "bench_rects",     0 },
+    { bench_polygons,  1024, 1024, "bench_polygons",  0 },
+    { bench_paths,     1024, 1024, "bench_paths",     0 },
+    { bench_gradients, 1024, 1024, "bench_gradients", 0 },
+    { bench_bitmaps,   1024, 1024, "bench_bitmaps",   0 },
+    { bench_meshes,    1024, 1024, "bench_meshes",    0 },
+
+    { nullptr, 0, 0, nullptr },
+};
+
+// Value at fraction q through the sorted samples (nearest rank)
+static double percentile(const std::vector<GNSec>& sorted, double q) {
+    size_t index = (size_t)std::ceil(q * sorted.size());
+    return (double)sorted[std::min(std::max(index, (size_t)1), sorted.size()) - 1];
+}
+
+static void bench_rec(const GDrawRec& rec, int warmup, int repeat) {
+    // Reused across runs; each run clears it first, as the image tool does
+    GBitmap bitmap;
+    bitmap.alloc(rec.fWidth, rec.fHeight,
+                 GBitmap::kAligned_AllocFlag | GBitmap::kUninitialized_AllocFlag);
+
+    std::vector<GNSec> samples;
+    for (int i = 0; i < warmup + repeat; ++i) {
+        GNSec start = GTime::GetNSec();
+        auto canvas = GCreateCanvas(bitmap);
+        canvas->clear({0, 0, 0, 0});
+        rec.fDraw(canvas.get());
+        GNSec elapsed = GTime::GetNSec() - start;
+        if (i >= warmup) {
+            samples.push_back(elapsed);
+        }
+    }
+    free(bitmap.pixels());
+
+    std::sort(samples.begin(), samples.end());
+    printf("%-20s %5dx%-5d %10.3f %10.3f %10.3f\n", rec.fName, rec.fWidth, rec.fHeight,
+           samples.front() * 1e-6, percentile(samples, 0.5) * 1e-6, percentile(samples, 0.95) * 1e-6);
+    fflush(stdout);
+}
+
+int main_bench(int argc, const char* argv[]) {
+    const char* match = NULL;
+    int repeat = 50;
+    int warmup = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        if (is_arg(argv[i], "match") && i+1 < argc) {
+            match = argv[++i];
+        } else if (is_arg(argv[i], "repeat") && i+1 < argc) {
+            repeat = std::max(1, atoi(argv[++i]));
+        } else if (is_arg(argv[i], "warmup") && i+1 < argc) {
+            warmup = std::max(0, atoi(argv[++i]));
+        }
+    }
+
+    printf("%-20s %11s %10s %10s %10s   (ms, %d runs after %d warm-up)\n",
+           "scene", "size", "min", "median", "p95", repeat, warmup);
+    for (const GDrawRec* recs : {gDrawRecs, gBenchRecs}) {
+        for (int i = 0; recs[i].fDraw; ++i) {
+            if (match && !strstr(recs[i].fName, match)) {
+                continue;
+            }
+            bench_rec(recs[i], warmup, repeat);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,291 @@
+/**
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "image.h"
+#include "../include/GCanvas.h"
+#include "../include/GBitmap.h"
+#include "../GBandRenderer.h"
+#include "../GPathLibrary.h"
+#include "../GPicture.h"
+#include "../include/GPathBuilder.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+/*
+ *  Behavior checks that compare the library against itself, rather than against expected images.
+ *  Each returns the number of failures, and prints a line for each.
+ */
+
+// Band rendering must match a direct render pixel for pixel, at any band height.
+static int check_bands() {
+    int failures = 0;
+    for (int i = 0; gDrawRecs[i].fDraw; ++i) {
+        const GDrawRec& rec = gDrawRecs[i];
+
+        GBitmap direct;
+        direct.alloc(rec.fWidth, rec.fHeight);
+        if (!direct.pixels()) {
+            continue;
+        }
+        auto canvas = GCreateCanvas(direct);
+        canvas->clear({0, 0, 0, 0});
+        rec.fDraw(canvas.get());
+
+        GRecordingCanvas recorder;
+        rec.fDraw(&recorder);
+        std::shared_ptr<GPicture> picture = recorder.finish();
+
+        for (int bandHeight : {1, 7, 64, rec.fHeight}) {
+            int diffs = 0;
+            bool ok = GRenderBands(*picture, rec.fWidth, rec.fHeight, bandHeight,
+                                   [&](int y, const GPixel row[], int width) {
+                for (int x = 0; x < width; ++x) {
+                    diffs += row[x] != *direct.getAddr(x, y);
+                }
+                return true;
+            });
+            if (!ok || diffs) {
+                printf("bands: %s with %d-row bands: %d pixels differ%s\n", rec.fName, bandHeight,
+                       diffs, ok ? "" : " (render failed)");
+                failures += 1;
+            }
+        }
+    }
+    return failures;
+}
+
+static int expect(bool ok, const char name[], const char what[]) {
+    if (!ok) {
+        printf("%s: %s\n", name, what);
+    }
+    return ok ? 0 : 1;
+}
+
+static int check_path_contains() {
+    const char* name = "path contains";
+    int failures = 0;
+
+    // Curves: the bounds' corners are outside a circle, and a quad's hump is inside up to its peak
+    auto circle = GPathBuilder::Build([](GPathBuilder& bu) { bu.addCircle({50, 50}, 40); });
+    failures += expect(circle->contains({50, 50}), name, "circle center");
+    failures += expect(circle->contains({50, 89}), name, "circle, just inside the bottom");
+    failures += expect(!circle->contains({15, 15}), name, "circle, bounds corner");
+    auto hump = GPathBuilder::Build([](GPathBuilder& bu) {
+        bu.moveTo(0, 0);
+        bu.quadTo(50, 100, 100, 0);
+    });
+    failures += expect(hump->contains({50, 45}), name, "quad, under its peak");
+    failures += expect(!hump->contains({50, 55}), name, "quad, past its peak");
+    failures += expect(!hump->contains({10, 40}), name, "quad, outside its side");
+
+    // Winding adds up: a same-direction inner contour stays filled, an opposite one is a hole
+    auto nested = GPathBuilder::Build([](GPathBuilder& bu) {
+        bu.addCircle({50, 50}, 40);
+        bu.addCircle({50, 50}, 20);
+    });
+    auto ring = GPathBuilder::Build([](GPathBuilder& bu) {
+        bu.addCircle({50, 50}, 40);
+        bu.addCircle({50, 50}, 20, GPathDirection::kCCW);
+    });
+    failures += expect(nested->contains({50, 50}), name, "nested circles, center");
+    failures += expect(!ring->contains({50, 50}), name, "ring, center");
+    failures += expect(ring->contains({50, 80}), name, "ring, between the circles");
+
+    // A point level with a vertex counts its two edges once: a diamond's side corners, and the
+    // notch of a V whose edges both end at the vertex
+    const GPoint diamondPts[] = {{50, 0}, {100, 50}, {50, 100}, {0, 50}};
+    auto diamond = GPathBuilder::Build([&](GPathBuilder& bu) { bu.addPolygon(diamondPts, 4); });
+    failures += expect(diamond->contains({50, 50}), name, "diamond, level with its corners");
+    failures += expect(diamond->contains({1, 50}), name, "diamond, next to its left corner");
+    const GPoint notchPts[] = {{0, 0}, {50, 50}, {100, 0}, {100, 100}, {0, 100}};
+    auto notch = GPathBuilder::Build([&](GPathBuilder& bu) { bu.addPolygon(notchPts, 5); });
+    failures += expect(notch->contains({10, 50}), name, "notch, level with its vertex");
+    failures += expect(!notch->contains({50, 40}), name, "notch, above its vertex");
+
+    // Edges are half-open like drawPath's rows: top and left are in, bottom and right are out
+    auto square = GPathBuilder::Build([](GPathBuilder& bu) { bu.addRect(GRect::LTRB(10, 10, 50, 50)); });
+    failures += expect(square->contains({10, 10}), name, "square, top-left corner");
+    failures += expect(!square->contains({50, 30}), name, "square, right edge");
+    failures += expect(!square->contains({30, 50}), name, "square, bottom edge");
+
+    failures += expect(!GPathBuilder().detach()->contains({0, 0}), name, "empty path");
+    return failures;
+}
+
+static int check_path_intersects() {
+    const char* name = "path intersects";
+    int failures = 0;
+
+    auto square = GPathBuilder::Build([](GPathBuilder& bu) { bu.addRect(GRect::LTRB(10, 10, 50, 50)); });
+    failures += expect(square->intersects(GRect::LTRB(20, 20, 30, 30)), name, "rect inside");
+    failures += expect(square->intersects(GRect::LTRB(0, 0, 100, 100)), name, "rect around");
+    failures += expect(square->intersects(GRect::LTRB(49, 20, 80, 30)), name, "rect overlapping an edge");
+    failures += expect(square->intersects(GRect::LTRB(40, 0, 60, 11)), name, "rect over a corner");
+
+    // Touching only along an edge or at a corner is not overlap
+    failures += expect(!square->intersects(GRect::LTRB(50, 20, 80, 30)), name, "rect on the right edge");
+    failures += expect(!square->intersects(GRect::LTRB(20, 0, 30, 10)), name, "rect on the top edge");
+    failures += expect(!square->intersects(GRect::LTRB(0, 0, 10, 10)), name, "rect on a corner");
+    failures += expect(!square->intersects(GRect::LTRB(20, 20, 20, 30)), name, "empty rect");
+
+    // The bounds can overlap while the interior doesn't: a circle's corner, and a ring's hole
+    auto ring = GPathBuilder::Build([](GPathBuilder& bu) {
+        bu.addCircle({50, 50}, 40);
+        bu.addCircle({50, 50}, 20, GPathDirection::kCCW);
+    });
+    failures += expect(!ring->intersects(GRect::LTRB(10, 10, 18, 18)), name, "ring, bounds corner");
+    failures += expect(!ring->intersects(GRect::LTRB(45, 45, 55, 55)), name, "ring, inside the hole");
+    failures += expect(ring->intersects(GRect::LTRB(45, 45, 55, 75)), name, "ring, hole to the band");
+    failures += expect(ring->intersects(GRect::LTRB(0, 48, 100, 52)), name, "ring, across the hole");
+    return failures;
+}
+
+// An index is keyed by its path's address, so a path allocated where a hit-tested one was freed
+// must not see the old path's index.
+static int check_path_index_reuse() {
+    const char* name = "path index reuse";
+    int failures = 0;
+
+    // Same counts, so the allocator tends to hand back the same block; same bounds, different inside
+    const GPoint upperLeft[] = {{0, 0}, {100, 0}, {0, 100}};
+    const GPoint lowerRight[] = {{100, 0}, {100, 100}, {0, 100}};
+    for (int i = 0; i < 8; ++i) {
+        const GPoint* pts = (i & 1) ? lowerRight : upperLeft;
+        auto path = GPathBuilder::Build([&](GPathBuilder& bu) { bu.addPolygon(pts, 3); });
+        bool upper = path->contains({20, 20});
+        bool lower = path->contains({80, 80});
+        failures += expect(upper == !(i & 1) && lower == !!(i & 1), name,
+                           (i & 1) ? "lower-right triangle" : "upper-left triangle");
+    }
+    return failures;
+}
+
+static bool same_path(const GPath& a, const GPath& b) {
+    GRect ra = a.bounds(), rb = b.bounds();
+    if (a.countPoints() != b.countPoints() || a.countVerbs() != b.countVerbs() ||
+        ra.left != rb.left || ra.top != rb.top || ra.right != rb.right || ra.bottom != rb.bottom) {
+        return false;
+    }
+    GPath::Iter ia(a), ib(b);
+    GPoint pa[GPath::kMaxNextPoints], pb[GPath::kMaxNextPoints];
+    while (auto va = ia.next(pa)) {
+        auto vb = ib.next(pb);
+        if (!vb || va.value() != vb.value()) {
+            return false;
+        }
+        int n = va.value() == kMove ? 1 : va.value() + 1;
+        if (memcmp(pa, pb, n * sizeof(GPoint)) != 0) {
+            return false;
+        }
+    }
+    return !ib.next(pb);
+}
+
+// Loads a copy of data patched by edit, in 8-byte aligned storage as Make requires.
+template <typename Edit> static bool loads_edited(const std::vector<uint8_t>& data, Edit edit) {
+    std::vector<uint64_t> storage((data.size() + 7) / 8);
+    uint8_t* bytes = (uint8_t*) storage.data();
+    memcpy(bytes, data.data(), data.size());
+    size_t size = edit(bytes, data.size());
+    return GPathLibrary::Make(bytes, size, nullptr) != nullptr;
+}
+
+static void put32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+static void put64(uint8_t* p, uint64_t v) { memcpy(p, &v, 8); }
+
+static int check_path_library() {
+    const char* name = "path library";
+    int failures = 0;
+
+    std::vector<std::shared_ptr<GPath>> paths = {
+        GPathBuilder::Build([](GPathBuilder& bu) { bu.addCircle({50, 50}, 40); }),
+        GPathBuilder().detach(),
+        GPathBuilder::Build([](GPathBuilder& bu) {
+            bu.addRect(GRect::LTRB(1, 2, 3, 4), GPathDirection::kCCW);
+            bu.moveTo(10, 10);
+            bu.cubicTo(20, -5, 30, 25, 40, 10);
+            bu.lineTo(10, 30);
+        }),
+    };
+
+    // Round trip, both in memory and through a mapped file
+    const std::vector<uint8_t> data = GPathLibrary::Serialize(paths);
+    std::vector<uint64_t> storage((data.size() + 7) / 8);
+    memcpy(storage.data(), data.data(), data.size());
+    const char* file = "checks_library.gplb";
+    bool wrote = GPathLibrary::Write(file, paths);
+    failures += expect(wrote, name, "write");
+    std::shared_ptr<GPathLibrary> libraries[] = {
+        GPathLibrary::Make(storage.data(), data.size(), nullptr),
+        wrote ? GPathLibrary::Map(file) : nullptr,
+    };
+    remove(file);
+    for (const auto& library : libraries) {
+        if (!library || library->count() != (int) paths.size()) {
+            failures += expect(false, name, "load");
+            continue;
+        }
+        for (size_t i = 0; i < paths.size(); ++i) {
+            failures += expect(same_path(*paths[i], *library->path((int) i)), name, "round trip");
+        }
+    }
+
+    // Anything that would read outside the data is rejected
+    const size_t kHeader = 16, kEntry = 40;
+    const size_t entry2 = kHeader + 2 * kEntry;  // the third path's entry
+    failures += expect(!loads_edited(data, [](uint8_t*, size_t size) { return size - 1; }), name,
+                       "truncated file");
+    failures += expect(!loads_edited(data, [](uint8_t*, size_t) { return (size_t) 8; }), name,
+                       "truncated header");
+    failures += expect(!loads_edited(data, [](uint8_t* p, size_t size) { p[0] = 'X'; return size; }), name,
+                       "bad magic");
+    failures += expect(!loads_edited(data, [](uint8_t* p, size_t size) {
+        put32(p + 12, 0x04030201);
+        return size;
+    }), name, "other byte order");
+    failures += expect(!loads_edited(data, [](uint8_t* p, size_t size) {
+        put32(p + 8, 0x10000000);
+        return size;
+    }), name, "count past the file");
+    failures += expect(!loads_edited(data, [=](uint8_t* p, size_t size) {
+        put64(p + entry2, (size + 7) & ~(size_t) 7);
+        return size;
+    }), name, "points past the file");
+    failures += expect(!loads_edited(data, [=](uint8_t* p, size_t size) {
+        put64(p + entry2, 8);
+        return size;
+    }), name, "points over the entries");
+    failures += expect(!loads_edited(data, [=](uint8_t* p, size_t size) {
+        put32(p + entry2 + 20, 0xFFFFFFFF);
+        return size;
+    }), name, "verb count past the file");
+    failures += expect(!loads_edited(data, [=](uint8_t* p, size_t size) {
+        put32(p + entry2 + 16, 0x7FFFFFFF);
+        return size;
+    }), name, "point count past the file");
+    failures += expect(!loads_edited(data, [=](uint8_t* p, size_t size) {
+        float nan = NAN;
+        memcpy(p + entry2 + 24, &nan, 4);
+        return size;
+    }), name, "NaN bounds");
+    failures += expect(!loads_edited(data, [](uint8_t* p, size_t size) {
+        p[size - 1] = 9;  // the last verb
+        return size;
+    }), name, "unknown verb");
+    return failures;
+}
+
+int main_checks(int argc, const char* argv[]) {
+    int failures = 0;
+    failures += check_bands();
+    failures += check_path_contains();
+    failures += check_path_intersects();
+    failures += check_path_index_reuse();
+    failures += check_path_library();
+
+    printf("%s: %d failure(s)\n", failures ? "FAILED" : "passed", failures);
+    return failures ? -1 : 0;
+}
@@ -3,6 +3,7 @@
  */
 
 #include "image.h"
+#include "args.h"
 #include "../include/GCanvas.h"
 #include "../include/GColor.h"
 #include "../include/GBitmap.h"
@@ -58,9 +59,11 @@ static double compare(const GBitmap& a, const GBitmap& b, int tolerance, bool ve
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 static void handle_proc(const GDrawRec& rec, const char path[], GBitmap* bitmap) {
-    bitmap->alloc(rec.fWidth, rec.fHeight);
+    // The canvas is cleared before drawing, so the pixels needn't be zeroed first
+    bitmap->alloc(rec.fWidth, rec.fHeight,
+                  GBitmap::kAligned_AllocFlag | GBitmap::kUninitialized_AllocFlag);
 
-    auto canvas = GCreateCanvas(*bitmap);
+    auto canvas = GCreateCanvas(bitmap);
     if (!canvas) {
         fprintf(stderr, "failed to create canvas for [%d %d] %s\n",
                 rec.fWidth, rec.fHeight, rec.fName);
@@ -75,20 +78,6 @@ static void handle_proc(const GDrawRec& rec, const char path[], GBitmap* bitmap)
     }
 }
 
-static bool is_arg(const char arg[], const char name[]) {
-    std::string str("--");
-    str += name;
-    if (!strcmp(arg, str.c_str())) {
-        return true;
-    }
-
-    char shortVers[3];
-    shortVers[0] = '-';
-    shortVers[1] = name[0];
-    shortVers[2] = 0;
-    return !strcmp(arg, shortVers);
-}
-
 static void add_image(FILE* f, const char path[], const char name[], const char suffix[],
                       const GBitmap& bm) {
     std::string str(name);
@@ -5,6 +5,7 @@
 #include "image.h"
 
 #include "../include/GFinal.h"
+#include "../include/GImageCache.h"
 #include "../include/GCanvas.h"
 #include "../include/GBitmap.h"
 #include "../include/GColor.h"
@@ -64,10 +65,9 @@ static void final_sweep(GCanvas* canvas) {
 /////////////////////////////////////////////////////////////////////////////////////////////
 
 static void final_coons(GCanvas* canvas) {
-    GBitmap bm;
-    bm.readFromFile("apps/spock.png");
-    assert(bm.width());
-    assert(bm.height());
+    auto bm = GImageCacheGet("apps/spock.png");
+    assert(bm && bm->width());
+    assert(bm->height());
 
     GPoint pts[] = {
         {0, 0}, {0.25f, 0.5}, {1, 0},
@@ -83,7 +83,7 @@ static void final_coons(GCanvas* canvas) {
     GPoint tex[] = {
         {0, 0}, {1, 0}, {1, 1}, {0, 1},
     };
-    GMatrix::Scale(bm.width(), bm.height()).mapPoints(tex, tex, 4);
+    GMatrix::Scale(bm->width(), bm->height()).mapPoints(tex, tex, 4);
 
     GPaint paint(GCreateBitmapShader(bm, GMatrix()));
 
@@ -118,11 +118,10 @@ static void draw_cm(GFinal* f, GCanvas* canvas, const GRect& r, const GColorMatr
 }
 
 static std::shared_ptr<GShader> make_bm_shader(const char path[], float w, float h) {
-    GBitmap bm;
-    bm.readFromFile(path);
-    assert(bm.width());
-    assert(bm.height());
-    return GCreateBitmapShader(bm, GMatrix::Scale(w/bm.width(), h/bm.height()));
+    auto bm = GImageCacheGet(path);
+    assert(bm && bm->width());
+    assert(bm->height());
+    return GCreateBitmapShader(bm, GMatrix::Scale(w/bm->width(), h/bm->height()));
 }
 
 static void final_colormarix(GCanvas* canvas) {
@@ -187,9 +186,9 @@ static void final_stroke(GCanvas* canvas) {
     const GPoint pts[] = {
         {dx, dy}, {512-dx, 512-dy}, {512-dx,dy}, {dx,512-dy},
     };
-    canvas->drawPath(f->strokePolygon(pts, 4, 70, true), paint);
+    canvas->drawStrokePolygon(pts, 4, 70, true, paint);
     paint.setBlendMode(GBlendMode::kClear);
-    canvas->drawPath(f->strokePolygon(pts, 4, 25, true), paint);
+    canvas->drawStrokePolygon(pts, 4, 25, true, paint);
     paint.setBlendMode(GBlendMode::kSrcOver);
 
     std::vector<GPoint> poly;
@@ -199,7 +198,7 @@ static void final_stroke(GCanvas* canvas) {
     canvas->translate(256, 310);
     canvas->scale(190,  190);
     paint.setColor({0,0,1,1});
-    canvas->drawPath(f->strokePolygon(poly.data(), poly.size(), w/256, true), paint);
+    canvas->drawStrokePolygon(poly.data(), poly.size(), w/256, true, paint);
     canvas->restore();
 
     poly = make_wiggle(25, 30);
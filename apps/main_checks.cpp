@@ -0,0 +1,11 @@
+/**
+ *  Copyright 2024 Christine Hu
+ */
+
+#include <stdio.h>
+
+extern int main_checks(int argc, const char* argv[]);
+
+int main(int argc, const char* argv[]) {
+    return main_checks(argc, argv);
+}
@@ -0,0 +1,265 @@
+/**
+ *  Copyright 2024 Christine Hu
+ *
+ *  Times the inner loops in isolation and prints ns/pixel as JSON:
+ *   - blit: axis-aligned drawRect spans, for each GBlendMode x source x span width
+ *   - shade: each shader's shadeRow, for each tile mode (where it has one) x context matrix
+ *
+ *  microbench [--match substr] [--samples N] [--time msPerSample]
+ */
+
+#include "args.h"
+#include "../include/GBitmap.h"
+#include "../include/GCanvas.h"
+#include "../include/GFinal.h"
+#include "../include/GPaint.h"
+#include "../include/GShader.h"
+#include "../include/GTime.h"
+#include "../TriShader_Factory.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+static const char* const gBlendModeNames[] = {
+    "kClear", "kSrc", "kDst", "kSrcOver", "kDstOver", "kSrcIn",
+    "kDstIn", "kSrcOut", "kDstOut", "kSrcATop", "kDstATop", "kXor",
+};
+
+static const char* const gTileModeNames[] = { "clamp", "repeat", "mirror" };
+
+static const int gSpanWidths[] = { 1, 4, 16, 64, 1024 };
+
+static const int kDeviceSize = 1024;
+
+struct Options {
+    const char* fMatch = nullptr;
+    int         fSamples = 5;
+    GNSec       fSampleNanos = 20 * 1000000;
+};
+
+/*
+ *  Runs proc (which touches pixelsPerCall pixels) in batches of at least opts.fSampleNanos, and
+ *  returns the best batch's ns/pixel. setup runs untimed before every callsPerSetup calls, and proc
+ *  is passed the number of calls made since then.
+ */
+static double time_per_pixel(const Options& opts, long pixelsPerCall, long callsPerSetup,
+                             const std::function<void()>& setup, const std::function<void(long)>& proc) {
+    // Size the batch from one warm-up call
+    setup();
+    GNSec start = GTime::GetNSec();
+    proc(0);
+    const GNSec once = std::max<GNSec>(GTime::GetNSec() - start, 1);
+    const long calls = std::max<long>(1, (long)(opts.fSampleNanos / once));
+
+    double best = 1e30;
+    for (int s = 0; s < opts.fSamples; ++s) {
+        GNSec elapsed = 0;
+        for (long done = 0; done < calls;) {
+            setup();
+            const long n = std::min(callsPerSetup, calls - done);
+            start = GTime::GetNSec();
+            for (long i = 0; i < n; ++i) {
+                proc(i);
+            }
+            elapsed += GTime::GetNSec() - start;
+            done += n;
+        }
+        best = std::min(best, (double)elapsed / ((double)calls * pixelsPerCall));
+    }
+    return best;
+}
+
+static bool matches(const Options& opts, const std::string& name) {
+    return !opts.fMatch || strstr(name.c_str(), opts.fMatch);
+}
+
+// A 64x64 checkerboard, opaque or with alpha varying across it
+static GBitmap make_checker(bool opaque) {
+    GBitmap bm;
+    bm.alloc(64, 64);
+    for (int y = 0; y < 64; ++y) {
+        for (int x = 0; x < 64; ++x) {
+            const int a = opaque ? 0xFF : 0x40 + 2 * x;
+            const int c = ((x ^ y) & 8) ? a : a / 3;
+            *bm.getAddr(x, y) = GPixel_PackARGB(a, c, a - c, a / 2);
+        }
+    }
+    bm.setIsOpaque(opaque ? GBitmap::kYes_IsOpaque : GBitmap::kNo_IsOpaque);
+    return bm;
+}
+
+// A translucent gradient to blend onto, so no mode can short-circuit on the destination
+static void fill_destination(const GBitmap& device) {
+    for (int y = 0; y < device.height(); ++y) {
+        GPixel* row = device.getAddr(0, y);
+        for (int x = 0; x < device.width(); ++x) {
+            const int a = 0x80 + (x & 0x7F);
+            row[x] = GPixel_PackARGB(a, (y & 0xFF) * a / 255, a / 2, a / 4);
+        }
+    }
+}
+
+static void bench_blits(const Options& opts, const GBitmap& opaqueBM, const GBitmap& alphaBM) {
+    GBitmap device, pristine;
+    device.alloc(kDeviceSize, kDeviceSize, GBitmap::kAligned_AllocFlag);
+    pristine.alloc(kDeviceSize, kDeviceSize, GBitmap::kAligned_AllocFlag);
+    fill_destination(pristine);
+    auto canvas = GCreateCanvas(device);
+    auto restore = [&]() { memcpy(device.pixels(), pristine.pixels(), device.rowBytes() * kDeviceSize); };
+
+    struct Source {
+        const char* fName;
+        GPaint      fPaint;
+    };
+    const Source sources[] = {
+        { "solid_opaque",       GPaint(GColor{0.8f, 0.4f, 0.2f, 1}) },
+        { "solid_translucent",  GPaint(GColor{0.8f, 0.4f, 0.2f, 0.6f}) },
+        { "shader_opaque",      GPaint(GCreateBitmapShader(opaqueBM, GMatrix(), GTileMode::kRepeat)) },
+        { "shader_translucent", GPaint(GCreateBitmapShader(alphaBM, GMatrix(), GTileMode::kRepeat)) },
+    };
+
+    printf("  \"blit\": [");
+    const char* separator = "\n";
+    for (int mode = 0; mode < (int)GARRAY_COUNT(gBlendModeNames); ++mode) {
+        for (const Source& src : sources) {
+            for (int width : gSpanWidths) {
+                const std::string name = std::string("blit/") + gBlendModeNames[mode] + "/" +
+                                         src.fName + "/" + std::to_string(width);
+                if (!matches(opts, name)) {
+                    continue;
+                }
+                GPaint paint = src.fPaint;
+                paint.setBlendMode((GBlendMode)mode);
+                // Each call is kDeviceSize spans of this width, in a column no call has drawn to since
+                // the device was last restored, so every call blends onto the original destination.
+                const long columns = kDeviceSize / width;
+                const double ns = time_per_pixel(opts, (long)width * kDeviceSize, columns, restore,
+                    [&](long i) {
+                        canvas->drawRect(GRect::XYWH((float)(i * width), 0, (float)width, (float)kDeviceSize), paint);
+                    });
+                printf("%s    {\"mode\": \"%s\", \"source\": \"%s\", \"width\": %d, \"ns_per_pixel\": %.4f}",
+                       separator, gBlendModeNames[mode], src.fName, width, ns);
+                separator = ",\n";
+                fflush(stdout);
+            }
+        }
+    }
+    printf("\n  ],\n");
+    free(device.pixels());
+    free(pristine.pixels());
+}
+
+static void bench_shaders(const Options& opts, const GBitmap& opaqueBM, const GBitmap& alphaBM) {
+    struct Shader {
+        std::string              fName;
+        int                      fTileMode;  // -1 if the shader has none
+        std::shared_ptr<GShader> fShader;
+    };
+    std::vector<Shader> shaders;
+
+    const GColor colors[] = {{1, 0, 0, 1}, {0, 1, 0, 0.5f}, {0, 0, 1, 1}, {1, 1, 0, 0.75f}};
+    const GColor opaqueColors[] = {{1, 0, 0, 1}, {0, 1, 0, 1}, {0, 0, 1, 1}};
+    for (int t = 0; t < 3; ++t) {
+        const GTileMode tile = (GTileMode)t;
+        const GMatrix local = GMatrix::Scale(3, 2);
+        shaders.push_back({"bitmap_opaque", t, GCreateBitmapShader(opaqueBM, local, tile)});
+        shaders.push_back({"bitmap_translucent", t, GCreateBitmapShader(alphaBM, local, tile)});
+        shaders.push_back({"linear_1", t, GCreateLinearGradient({10, 10}, {200, 80}, colors, 1, tile)});
+        shaders.push_back({"linear_2", t, GCreateLinearGradient({10, 10}, {200, 80}, colors, 2, tile)});
+        shaders.push_back({"linear_4", t, GCreateLinearGradient({10, 10}, {200, 80}, colors, 4, tile)});
+    }
+
+    auto final = GCreateFinal();
+    const GPoint sites[] = {{20, 30}, {200, 60}, {90, 220}, {240, 250}, {130, 130}, {10, 200}};
+    // Voronoi takes its colors as-is, so they must be opaque (premul == unpremul)
+    const GColor siteColors[] = {opaqueColors[0], opaqueColors[1], opaqueColors[2],
+                                 opaqueColors[0], opaqueColors[1], opaqueColors[2]};
+    const float pos[] = {0, 0.1f, 0.7f, 1};
+    shaders.push_back({"sweep", -1, final->createSweepGradient({128, 128}, 0.5f, colors, 4)});
+    shaders.push_back({"voronoi", -1, final->createVoronoiShader(sites, siteColors, 6)});
+    shaders.push_back({"linearpos", -1, final->createLinearPosGradient({10, 10}, {200, 80}, colors, pos, 4)});
+
+    // Proxy shaders hold raw pointers, so the shader they wrap is kept alive here
+    auto texture = GCreateBitmapShader(opaqueBM, GMatrix::Scale(3, 2), GTileMode::kRepeat);
+    const GColorMatrix gray({0.299f, 0.299f, 0.299f, 0, 0.587f, 0.587f, 0.587f, 0,
+                             0.114f, 0.114f, 0.114f, 0, 0, 0, 0, 1, 0, 0, 0, 0});
+    shaders.push_back({"colormatrix", -1, final->createColorMatrixShader(gray, texture.get())});
+
+    const GPoint tri[] = {{0, 0}, {300, 40}, {60, 280}};
+    auto triGradient = GCreateTriGradientShader(tri[0], tri[1], tri[2], colors[0], colors[1], colors[2]);
+    auto triSticking = GCreateTriStickingShader(tri[0], tri[1], tri[2], {0, 0}, {64, 0}, {0, 64}, texture.get());
+    shaders.push_back({"tri_gradient", -1, triGradient});
+    shaders.push_back({"tri_gradient_opaque", -1, GCreateTriGradientShader(tri[0], tri[1], tri[2],
+                       opaqueColors[0], opaqueColors[1], opaqueColors[2])});
+    shaders.push_back({"tri_sticking", -1, triSticking});
+    shaders.push_back({"tri_compose", -1, GCreateTriComposeShader(triGradient.get(), triSticking.get())});
+
+    struct Context {
+        const char* fName;
+        GMatrix     fMatrix;
+    };
+    const Context contexts[] = {
+        { "identity", GMatrix() },
+        { "scale",    GMatrix::Scale(2.5f, 1.5f) },
+        { "rotate",   GMatrix::Translate(300, -50) * GMatrix::Rotate(0.5f) },
+    };
+
+    const int kRowWidth = 256;
+    const int kRows = 64;
+    std::vector<GPixel> row(kRowWidth);
+
+    printf("  \"shade\": [");
+    const char* separator = "\n";
+    for (const Shader& sh : shaders) {
+        if (!sh.fShader) {
+            continue;
+        }
+        const char* tile = sh.fTileMode < 0 ? "none" : gTileModeNames[sh.fTileMode];
+        for (const Context& ctx : contexts) {
+            const std::string name = "shade/" + sh.fName + "/" + tile + "/" + ctx.fName;
+            if (!matches(opts, name)) {
+                continue;
+            }
+            const double ns = time_per_pixel(opts, (long)kRowWidth * kRows, LONG_MAX,
+                [&]() { sh.fShader->setContext(ctx.fMatrix); },
+                [&](long) {
+                    for (int y = 0; y < kRows; ++y) {
+                        sh.fShader->shadeRow(0, y, kRowWidth, row.data());
+                    }
+                });
+            printf("%s    {\"shader\": \"%s\", \"tile\": \"%s\", \"matrix\": \"%s\", \"ns_per_pixel\": %.4f}",
+                   separator, sh.fName.c_str(), tile, ctx.fName, ns);
+            separator = ",\n";
+            fflush(stdout);
+        }
+    }
+    printf("\n  ]\n");
+}
+
+int main_microbench(int argc, const char* argv[]) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (is_arg(argv[i], "match") && i+1 < argc) {
+            opts.fMatch = argv[++i];
+        } else if (is_arg(argv[i], "samples") && i+1 < argc) {
+            opts.fSamples = std::max(1, atoi(argv[++i]));
+        } else if (is_arg(argv[i], "time") && i+1 < argc) {
+            opts.fSampleNanos = (GNSec)std::max(1, atoi(argv[++i])) * 1000000;
+        }
+    }
+
+    GBitmap opaqueBM = make_checker(true);
+    GBitmap alphaBM = make_checker(false);
+
+    printf("{\n  \"unit\": \"ns/pixel\",\n  \"samples\": %d,\n", opts.fSamples);
+    bench_blits(opts, opaqueBM, alphaBM);
+    bench_shaders(opts, opaqueBM, alphaBM);
+    printf("}\n");
+
+    free(opaqueBM.pixels());
+    free(alphaBM.pixels());
+    return 0;
+}
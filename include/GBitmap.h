@@ -7,6 +7,8 @@
 
 #include "GPixel.h"
 
+struct GPNGOptions;
+
 class GBitmap {
 public:
     GBitmap() { this->reset(); }
@@ -29,6 +31,7 @@ public:
         fPixels = NULL;
         fRowBytes = 0;
         fIsOpaque = false;  // unknown
+        fIsMapped = false;
     }
 
     enum IsOpaque {
@@ -55,7 +58,8 @@ public:
     }
 
     /**
-     *  Attempt to read the png image stored in the named file.
+     *  Attempt to read the png image stored in the named file. Files named *.qoi or *.pam are read
+     *  as QOI or as a raw pixel dump instead (see src/GImageFormats.h).
      *
      *  On success, allocate the memory for the pixels using malloc() and set bitmap to the result,
      *  returning true. The caller must call free(bitmap->fPixels) when they are finished.
@@ -68,21 +72,63 @@ public:
 
     /*
      *  Attempt to write the bitmap as a PNG into a new file (the file will be created/overwritten).
+     *  As with readFromFile, a .qoi or .pam extension selects one of the faster formats.
      *  Return true on success.
      */
     bool writeToFile(const char path[]) const;
 
+    /*
+     *  Same, with control over threading and compression effort (see GPNGWriter.h).
+     */
+    bool writeToFile(const char path[], const GPNGOptions&) const;
+
     /**
      *  Allocate the memory for the bitmap. If rowBytes is 0, it will be computed from w.
      */
     void alloc(int w, int h, size_t rowBytes = 0);
 
+    enum AllocFlags {
+        kDefault_AllocFlags      = 0,
+        kAligned_AllocFlag       = 1 << 0,  // 64-byte (cache line) aligned base and row pitch
+        kUninitialized_AllocFlag = 1 << 1,  // skip zeroing, e.g. when the first draw is a clear
+    };
+    static constexpr size_t kAllocAlignment = 64;
+
+    /**
+     *  Allocate the memory for the bitmap as the flags ask. With kAligned_AllocFlag, each row is
+     *  padded to a multiple of kAllocAlignment bytes. The pixels are still released with free().
+     */
+    void alloc(int w, int h, AllocFlags);
+
+    /**
+     *  Like alloc(), but the pixels are a shared mapping of a sparse file instead of heap memory, so
+     *  a bitmap far larger than RAM only needs the rows in use resident: the OS writes cold pages
+     *  back to the file rather than swapping or running out of memory. The file is path if given
+     *  (created or truncated, and kept afterwards), else an unlinked temporary in $TMPDIR or /tmp.
+     *
+     *  Returns false, leaving the bitmap empty, if the file or the mapping can't be made. Release
+     *  the pixels with releaseMapped(), not free().
+     */
+    bool allocMapped(int w, int h, const char path[] = nullptr);
+    void releaseMapped();
+    bool isMapped() const { return fIsMapped; }
+
+    enum RowAdvice {
+        kWillNeed_RowAdvice,  // about to be drawn or read: start paging them in
+        kDone_RowAdvice,      // finished for now: start writeback and drop them from memory
+    };
+    /**
+     *  Paging hint for rows [top, bottom) of an allocMapped() bitmap (a no-op for others).
+     */
+    void adviseRows(int top, int bottom, RowAdvice) const;
+
 private:
     int     fWidth;
     int     fHeight;
     GPixel* fPixels;
     size_t  fRowBytes;
     bool    fIsOpaque;  // hint that all pixels have 0xFF for alpha
+    bool    fIsMapped = false;  // pixels come from allocMapped()
 
     void validate() const {
         assert(fWidth >= 0);
@@ -97,6 +143,10 @@ private:
     static bool ComputeIsOpaque(const GBitmap&);
 };
 
+inline GBitmap::AllocFlags operator|(GBitmap::AllocFlags a, GBitmap::AllocFlags b) {
+    return (GBitmap::AllocFlags)((int)a | (int)b);
+}
+
 template <typename S> void visit_pixels(const GBitmap& bm, S&& visitor) {
     for (int y = 0; y < bm.height(); ++y) {
         for (int x = 0; x < bm.width(); ++x) {
@@ -45,6 +45,11 @@ public:
      */
     virtual void concat(const GMatrix& matrix) = 0;
 
+    /**
+     *  Returns the current CTM: every concat() since the canvas was made, less any undone by restore().
+     */
+    virtual GMatrix getTotalMatrix() const = 0;
+
     /**
      *  Fill the entire canvas with the specified color, using kSrc porter-duff mode.
      */
@@ -74,6 +79,14 @@ public:
             this->drawPath(*path, paint);
         }
     }
+
+    /**
+     *  Fill the stroke of the polygon: width wide, with round joins and caps (and closed back to
+     *  the first point if isClosed). The default draws the outline path from GStrokePolygon() with
+     *  drawPath(); a subclass may draw the outline without building the path.
+     */
+    virtual void drawStrokePolygon(const GPoint[], int count, float width, bool isClosed, const GPaint&);
+
     /**
      *  Draw a mesh of triangles, with optional colors and/or texture-coordinates at each vertex.
      *
@@ -166,6 +179,13 @@ public:
  */
 std::unique_ptr<GCanvas> GCreateCanvas(const GBitmap& bitmap);
 
+/**
+ *  Same, but the canvas also keeps bitmap's opaque hint (GBitmap::isOpaque) up to date as it
+ *  draws, so e.g. a bitmap shader of the result can take its opaque fast paths without a rescan.
+ *  bitmap must outlive the canvas.
+ */
+std::unique_ptr<GCanvas> GCreateCanvas(GBitmap* bitmap);
+
 /**
  *  Implement this, drawing into the provided canvas, and returning the title of your artwork.
  */
@@ -0,0 +1,38 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GImageCache_DEFINED
+#define GImageCache_DEFINED
+
+#include "GBitmap.h"
+#include <memory>
+
+/**
+ *  Process-wide cache of decoded images, so assets drawn on every render are decoded once.
+ *
+ *  Returns the pixels of the image file at path (any format GBitmap::readFromFile reads), shared
+ *  with every other caller of the same file. Each call only stat()s the file: a changed
+ *  modification time or size decodes it again, and callers still holding the old bitmap keep
+ *  it. The pixels are a heap copy owned by the cache, so replacing or truncating the file never
+ *  affects them. They are immutable; never draw into them or free them. They are released when
+ *  the last reference goes, whether or not the entry is still cached.
+ *
+ *  Returns null if the file can't be read. Safe to call from any thread.
+ */
+std::shared_ptr<const GBitmap> GImageCacheGet(const char path[]);
+
+/**
+ *  Limit on the decoded bytes the cache itself keeps alive (default 64MB). Least recently used
+ *  entries are dropped to stay under it; an image larger than the whole budget isn't cached.
+ */
+void GImageCacheSetBudget(size_t bytes);
+
+size_t GImageCacheBytesUsed();
+
+/**
+ *  Drop every entry (bitmaps still referenced elsewhere stay valid).
+ */
+void GImageCachePurge();
+
+#endif
@@ -28,6 +28,29 @@ public:
 
     GMatrix(const GMatrix& other) = default;
 
+    /**
+     *  What kind of transform this is, from cheapest to most general. Computed on first use and
+     *  cached. Any access through the non-const operator[] (reads included) invalidates it, so hot
+     *  code should read a matrix it doesn't modify through a const GMatrix&.
+     */
+    enum TypeMask {
+        kIdentity_Mask  = 0,
+        kTranslate_Mask = 1 << 0,  // e, f
+        kScale_Mask     = 1 << 1,  // a, d
+        kAffine_Mask    = 1 << 2,  // b, c (rotation / skew)
+    };
+
+    TypeMask getType() const {
+        if (fTypeMask == kUnknown_Mask) {
+            fTypeMask = this->computeTypeMask();
+        }
+        return (TypeMask) fTypeMask;
+    }
+
+    bool isIdentity() const { return this->getType() == kIdentity_Mask; }
+    bool isTranslate() const { return (this->getType() & ~kTranslate_Mask) == 0; }
+    bool isScaleTranslate() const { return (this->getType() & kAffine_Mask) == 0; }
+
     GVector e0() const { return {fMat[0], fMat[1]}; }
     GVector e1() const { return {fMat[2], fMat[3]}; }
     GVector origin() const { return {fMat[4], fMat[5]}; }
@@ -38,6 +61,7 @@ public:
     }
     float& operator[](int index) {
         assert(index >= 0 && index < 6);
+        fTypeMask = kUnknown_Mask;
         return fMat[index];
     }
 
@@ -102,7 +126,24 @@ public:
     }
 
 private:
+    enum { kUnknown_Mask = 0x80 };
+
+    uint8_t computeTypeMask() const {
+        uint8_t mask = kIdentity_Mask;
+        if (fMat[4] != 0 || fMat[5] != 0) {
+            mask |= kTranslate_Mask;
+        }
+        if (fMat[0] != 1 || fMat[3] != 1) {
+            mask |= kScale_Mask;
+        }
+        if (fMat[1] != 0 || fMat[2] != 0) {
+            mask |= kAffine_Mask;
+        }
+        return mask;
+    }
+
     float fMat[6];
+    mutable uint8_t fTypeMask = kUnknown_Mask;
 };
 
 #endif
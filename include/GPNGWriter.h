@@ -0,0 +1,91 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GPNGWriter_DEFINED
+#define GPNGWriter_DEFINED
+
+#include "GPixel.h"
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <vector>
+
+struct GPNGOptions {
+    // > 1 deflates that many chunks concurrently, up to one per hardware thread (0 means exactly
+    // that). Chunks never share a match window, so this only costs the slightly worse compression
+    // of the smaller parallel chunk size.
+    int  fThreads = 1;
+    // Chooses filters from only Sub and Up and uses a short, greedy match search.
+    bool fFast = false;
+
+    static GPNGOptions Fast(int threads = 1) {
+        GPNGOptions opts;
+        opts.fThreads = threads;
+        opts.fFast = true;
+        return opts;
+    }
+};
+
+/**
+ *  Writes a PNG one row at a time, with memory that does not depend on the image height: each row
+ *  is unpremultiplied and filtered into a small buffer, and every kChunkBytes of filtered rows are
+ *  deflated and written out as their own IDAT chunk.
+ *
+ *      GPNGWriter writer;
+ *      if (writer.begin(path, w, h)) {
+ *          for (int y = 0; y < h; ++y) writer.writeRow(rowAt(y));
+ *      }
+ *      bool ok = writer.finish();
+ */
+class GPNGWriter {
+public:
+    GPNGWriter() {}
+    ~GPNGWriter();
+
+    /**
+     *  Creates the file and writes the PNG header. Returns false on failure.
+     */
+    bool begin(const char path[], int width, int height, const GPNGOptions& = GPNGOptions());
+
+    /**
+     *  Appends the next row (top to bottom) of width premultiplied pixels.
+     */
+    bool writeRow(const GPixel row[]);
+
+    /**
+     *  Compresses what is left and closes the file. Returns true only if every row was written and
+     *  all of the output succeeded.
+     */
+    bool finish();
+
+    // Filtered row bytes deflated at a time (larger compresses slightly better, using more memory).
+    // Parallel encoding uses smaller chunks so that mid-sized images still spread across threads.
+    enum {
+        kChunkBytes         = 1 << 20,
+        kParallelChunkBytes = 1 << 18,
+    };
+
+private:
+    bool flush(bool last);
+    bool writeNextIDAT(bool appendAdler);
+    bool writeChunk(const char type[4], const std::vector<uint8_t>& data);
+
+    using Deflated = std::vector<uint8_t>;  // empty on error
+
+    FILE*                fFile = nullptr;
+    int                  fWidth = 0;
+    int                  fHeight = 0;
+    int                  fRowsWritten = 0;
+    GPNGOptions          fOptions;
+    size_t               fChunkBytes = kChunkBytes;
+    bool                 fOK = false;
+    bool                 fStarted = false;   // zlib header written
+    unsigned             fAdler = 1;
+    std::vector<uint8_t> fPrevRow, fCurrRow;  // unfiltered RGBA
+    std::vector<uint8_t> fCandidates;         // one filtered row per filter type
+    std::vector<uint8_t> fFiltered;           // filtered rows waiting to be deflated
+    std::deque<std::future<Deflated>> fPending;  // chunks being deflated, in file order
+};
+
+#endif
@@ -31,6 +31,19 @@ public:
     GBlendMode getBlendMode() const { return fMode; }
     GPaint&    setBlendMode(GBlendMode m) { fMode = m; return *this; }
 
+    /**
+     *  Max distance (in device pixels) between a curve and the lines it is flattened into when
+     *  drawn. Larger is coarser and faster (e.g. previews), smaller is finer.
+     */
+    float   getTolerance() const { return fTolerance; }
+    GPaint& setTolerance(float tolerance) {
+        fTolerance = tolerance > kMinTolerance ? tolerance : kMinTolerance;
+        return *this;
+    }
+
+    static constexpr float kDefaultTolerance = 0.25f;
+    static constexpr float kMinTolerance = 1.f / 64;
+
     GShader* peekShader() const { return fShader.get(); }
     std::shared_ptr<GShader> shareShader() const { return fShader; }
     GPaint&  setShader(std::shared_ptr<GShader> s) { fShader = s; return *this; }
@@ -39,6 +52,7 @@ private:
     GColor                      fColor = {0, 0, 0, 1};
     std::shared_ptr<GShader>    fShader;
     GBlendMode                  fMode = GBlendMode::kSrcOver;
+    float                       fTolerance = kDefaultTolerance;
 };
 
 #endif
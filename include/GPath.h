@@ -5,9 +5,11 @@
 #include "GPoint.h"
 #include "GRect.h"
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
-enum GPathVerb {
+enum GPathVerb : uint8_t {
     kMove,  // returns pts[0] from Iter
     kLine,  // returns pts[0]..pts[1] from Iter and Edger
     kQuad,  // returns pts[0]..pts[2] from Iter and Edger
@@ -25,10 +27,24 @@ public:
      *  Return the bounds of all of the control-points in the path.
      *
      *  If there are no points, returns an empty rect (all zeros)
+     *
+     *  Note: the bounds are computed once, when the path is created.
+     */
+    GRect bounds() const { return fBounds; }
+
+    /**
+     *  Returns true if the point is inside the path, using the non-zero winding rule (the same
+     *  edges drawPath fills: those returned by Edger).
+     */
+    bool contains(GPoint) const;
+
+    /**
+     *  Returns true if any part of the path's (non-zero winding) interior overlaps the rect.
      */
-    GRect bounds() const;
+    bool intersects(const GRect&) const;
 
-    size_t countPoints() const { return fPts.size(); }
+    size_t countPoints() const { return fPtCount; }
+    size_t countVerbs() const { return fVbCount; }
 
     /**
      *  Create a new path by transforming the points in this path.
@@ -82,18 +98,26 @@ public:
      *       switch (v.value()) {
      *           case GPath::kLine: // pts[0] and pts[1] are valid
      *  }
+     *
+     *  Given a matrix, the returned points are mapped by it on the fly, which walks the path as if
+     *  it were path.transform(matrix) without allocating a new path.
      */
     class Edger {
     public:
         Edger(const GPath&);
+        Edger(const GPath&, const GMatrix&);
         nonstd::optional<GPathVerb> next(GPoint pts[]);
 
     private:
+        nonstd::optional<GPathVerb> nextLocal(GPoint pts[]);
+
         const GPoint*    fPrevMove;
         const GPoint*    fCurrPt;
         const GPathVerb* fCurrVb;
         const GPathVerb* fStopVb;
         int fPrevVerb;
+        GMatrix fMatrix;
+        bool fMapPoints;
     };
 
     /**
@@ -112,19 +136,63 @@ public:
      */
     static void ChopCubicAt(const GPoint src[4], GPoint dst[7], float t);
 
-    GPath(std::vector<GPoint> pts, std::vector<GPathVerb> vbs)
-        : fPts(std::move(pts))
-        , fVbs(std::move(vbs))
-    {}
+    /**
+     *  Copies the points and verbs into a new path. The path, its points and verbs, and the
+     *  shared_ptr's control block are a single allocation, sized to fit.
+     */
+    static std::shared_ptr<GPath> Make(const GPoint pts[], int ptCount, const GPathVerb vbs[], int vbCount);
+
+    static std::shared_ptr<GPath> Make(const std::vector<GPoint>& pts, const std::vector<GPathVerb>& vbs) {
+        return Make(pts.data(), (int) pts.size(), vbs.data(), (int) vbs.size());
+    }
+
+    /**
+     *  Wraps points and verbs stored elsewhere (e.g. a mapped GPathLibrary file) without copying.
+     *  owner keeps that storage alive for as long as the path is; bounds must be the tight bounds.
+     */
+    static std::shared_ptr<GPath> MakeExternal(const GPoint pts[], int ptCount, const GPathVerb vbs[],
+                                               int vbCount, const GRect& bounds,
+                                               std::shared_ptr<const void> owner);
+
+    ~GPath();
+
+private:
+    // Only GPath's factories can name a Key, so only they can construct one (allocate_shared needs
+    // the constructor itself to be public).
+    struct Key {
+        explicit Key() = default;
+    };
+
+public:
+    GPath(Key) {}
 
 private:
     GPath(const GPath&) = delete;
     GPath& operator=(const GPath&) = delete;
 
     friend class GPathBuilder;
+    friend class GPathLibrary;
 
-    const std::vector<GPoint>    fPts;
-    const std::vector<GPathVerb> fVbs;
+    /**
+     *  Returns an empty path with room for ptCount points followed by vbCount verbs, allocated with
+     *  it. The caller fills them in and sets fBounds.
+     */
+    static std::shared_ptr<GPath> Alloc(int ptCount, int vbCount, GPoint** pts, GPathVerb** vbs);
+
+    const GPoint*    fPts = nullptr;
+    const GPathVerb* fVbs = nullptr;
+    int              fPtCount = 0;
+    int              fVbCount = 0;
+    GRect            fBounds = GRect::LTRB(0, 0, 0, 0);  // tight bounds (curve extrema included)
+
+    GRect computeBounds() const;
+
+    // Monotone segments indexed by y, built on the first contains() / intersects(). Few paths are
+    // ever hit-tested, so the indices live in a side table, not in each path.
+    struct SegmentIndex;
+    struct SegmentIndexTable;
+    std::shared_ptr<const SegmentIndex> segmentIndex() const;
+    static void DropSegmentIndex(const GPath*);
 };
 
 #endif
@@ -5,6 +5,7 @@
 #include "GRect.h"
 #include "GPath.h"
 
+#include <algorithm>
 #include <functional>
 #include <optional>
 #include <vector>
@@ -71,6 +72,19 @@ public:
 
     void transform(const GMatrix&);
 
+    /**
+     *  Reserve room for this many more points and verbs, so they can be added without reallocating.
+     */
+    void reserve(int extraPoints, int extraVerbs) {
+        // Grow geometrically, so reserving before every small contour stays amortized O(1).
+        if (fPts.size() + extraPoints > fPts.capacity()) {
+            fPts.reserve(std::max(fPts.size() + extraPoints, 2 * fPts.capacity()));
+        }
+        if (fVbs.size() + extraVerbs > fVbs.capacity()) {
+            fVbs.reserve(std::max(fVbs.size() + extraVerbs, 2 * fVbs.capacity()));
+        }
+    }
+
     /**
      * Return a GPath from the contents of this builder,
      * and then reset() the builder back to its empty state.
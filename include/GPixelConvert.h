@@ -0,0 +1,45 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GPixelConvert_DEFINED
+#define GPixelConvert_DEFINED
+
+#include "GPixel.h"
+#include <cstdint>
+
+/**
+ *  Bulk conversions between premultiplied GPixels and unpremultiplied RGBA bytes (the layout PNG
+ *  and most other formats use). Both match the straightforward division formulas exactly:
+ *
+ *      unpremul:  c' = (c * 255 + a/2) / a      (0 when a == 0; c is pinned to a first)
+ *      premul:    c' = (c * a + 127) / 255
+ *
+ *  but use a reciprocal table (scalar) or SSE2 instead of dividing.
+ */
+void GConvertPremulToRGBA(const GPixel src[], int count, uint8_t dst[]);
+
+// Returns true if every converted pixel was opaque (so callers get opacity for free)
+bool GConvertRGBAToPremul(const uint8_t src[], int count, GPixel dst[]);
+
+// scale[a] = ceil(2^24 / a), and 0 for a == 0
+struct GUnpremulTable {
+    uint32_t scale[256];
+    constexpr GUnpremulTable() : scale() {
+        for (uint32_t a = 1; a < 256; ++a) {
+            scale[a] = ((1u << 24) + a - 1) / a;
+        }
+    }
+};
+inline constexpr GUnpremulTable gUnpremulTable;
+
+/**
+ *  Single-component unpremul, same result as GConvertPremulToRGBA.
+ */
+static inline unsigned GUnpremulComponent(unsigned c, unsigned a) {
+    c = c < a ? c : a;
+    // the reciprocal is off by less than 1/a over this range, so the quotient is exact
+    return (unsigned) (((uint64_t) (c * 255 + (a >> 1)) * gUnpremulTable.scale[a]) >> 24);
+}
+
+#endif
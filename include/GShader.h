@@ -47,6 +47,13 @@ public:
 std::shared_ptr<GShader> GCreateBitmapShader(const GBitmap&, const GMatrix& localMatrix,
                                              GTileMode = GTileMode::kClamp);
 
+/**
+ *  Same, but the shader also shares ownership of the bitmap (e.g. one from GImageCacheGet()), so
+ *  its pixels stay valid for as long as the shader does.
+ */
+std::shared_ptr<GShader> GCreateBitmapShader(std::shared_ptr<const GBitmap>, const GMatrix& localMatrix,
+                                             GTileMode = GTileMode::kClamp);
+
 /**
  *  Return a subclass of GShader that draws the specified gradient of [count] colors between
  *  the two points. Color[0] corresponds to p0, and Color[count-1] corresponds to p1, and all
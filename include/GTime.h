@@ -8,10 +8,17 @@
 #include "GTypes.h"
 
 using GMSec = unsigned long;
+using GNSec = uint64_t;
 
 class GTime {
 public:
     static GMSec GetMSec();
+
+    /**
+     *  Nanoseconds from a monotonic clock (unaffected by changes to the wall-clock time), for
+     *  measuring intervals. The starting point is arbitrary.
+     */
+    static GNSec GetNSec();
 };
 
 #endif
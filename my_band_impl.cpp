@@ -0,0 +1,50 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "GBandRenderer.h"
+#include "include/GBitmap.h"
+#include "starter_canvas.h"
+#include <algorithm>
+#include <cstdlib>
+
+bool GRenderBands(const GPicture& picture, int width, int height, int bandHeight,
+                  const GBandRowProc& rowProc) {
+  if (width <= 0 || height <= 0) {
+    return true;
+  }
+  bandHeight = std::max(1, std::min(bandHeight, height));
+
+  GBitmap strip;
+  strip.alloc(width, bandHeight, GBitmap::kAligned_AllocFlag | GBitmap::kUninitialized_AllocFlag);
+  if (!strip.pixels()) {
+    return false;
+  }
+  bool keepGoing = true;
+  for (int top = 0; top < height && keepGoing; top += bandHeight) {
+    // The last band may be shorter
+    const int rows = std::min(bandHeight, height - top);
+    GBitmap band(width, rows, strip.rowBytes(), strip.pixels(), false);
+    MyCanvas canvas(band, top, height);
+    canvas.clear({0, 0, 0, 0});
+    picture.playback(&canvas, (float) top, (float) (top + rows));
+
+    for (int y = 0; y < rows && keepGoing; y++) {
+      keepGoing = rowProc(top + y, band.getAddr(0, y), width);
+    }
+  }
+  free(strip.pixels());
+  return keepGoing;
+}
+
+bool GRenderBandsToPNG(const GPicture& picture, int width, int height, const char path[],
+                       int bandHeight, const GPNGOptions& options) {
+  GPNGWriter writer;
+  if (!writer.begin(path, width, height, options)) {
+    return false;
+  }
+  GRenderBands(picture, width, height, bandHeight, [&writer](int, const GPixel row[], int) {
+    return writer.writeRow(row);
+  });
+  return writer.finish();
+}
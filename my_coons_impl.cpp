@@ -0,0 +1,116 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "GCoons.h"
+#include <vector>
+
+// Max distance (in device pixels) between the patch and its triangles.
+static const float kCoonsTolerance = 0.5f;
+static const int kMaxCoonsLevel = 64;
+
+int GCoonsLevel(const GPoint devicePts[8]) {
+  /* Each boundary is a quadratic; split into n pieces, a piece is at most |p0 - 2p1 + p2| / (4n^2)
+   * away from its chord. The twist of the corners bounds how far the bilinear part of the patch
+   * strays from two flat triangles per cell in the same way.
+   */
+  const GPoint* p = devicePts;
+  float curvature = std::max({
+      (p[0] - 2 * p[1] + p[2]).length(),
+      (p[6] - 2 * p[5] + p[4]).length(),
+      (p[0] - 2 * p[7] + p[6]).length(),
+      (p[2] - 2 * p[3] + p[4]).length(),
+      (p[0] - p[2] + p[4] - p[6]).length(),
+  });
+  int n = (int) ceilf(sqrtf(curvature / (4 * kCoonsTolerance)));
+  return std::min(std::max(n - 1, 0), kMaxCoonsLevel);
+}
+
+void GDrawCoonsMesh(GCanvas* canvas, const GPoint pts[8], const GPoint tex[4], int level, const GPaint& paint) {
+  int n = level + 1;
+  int numLines = n + 1;
+  float h = 1.f / n;
+
+  std::vector<GPoint> verts(numLines * numLines);
+  std::vector<GPoint> texs(tex ? numLines * numLines : 0);
+  std::vector<int> indices(n * n * 6);
+
+  /* For a fixed v, the patch is a quadratic in u:
+   *   S(u, v) = a(v) u^2 + b(v) u + L(v)
+   *   a(v) = lerp(top'' / 2, bottom'' / 2, v)
+   *   b(v) = lerp(top'(0), bottom'(0), v) + R(v) - L(v) - lerp(p2 - p0, p4 - p6, v)
+   * a and the lerps are linear in v, and L, R are quadratics in v, so every row start is also
+   * forward differenced.
+   */
+  GPoint aTop = pts[0] - 2 * pts[1] + pts[2];
+  GPoint aBot = pts[6] - 2 * pts[5] + pts[4];
+  GPoint bTop = 2 * (pts[1] - pts[0]) - (pts[2] - pts[0]);
+  GPoint bBot = 2 * (pts[5] - pts[6]) - (pts[4] - pts[6]);
+
+  // Quadratic forward differences for L(v) and R(v): value, first and second difference.
+  GPoint aL = pts[0] - 2 * pts[7] + pts[6], aR = pts[2] - 2 * pts[3] + pts[4];
+  GPoint L = pts[0], dL = aL * (h * h) + 2 * (pts[7] - pts[0]) * h, ddL = aL * (2 * h * h);
+  GPoint R = pts[2], dR = aR * (h * h) + 2 * (pts[3] - pts[2]) * h, ddR = aR * (2 * h * h);
+
+  int k = 0;
+  for (int i = 0; i < numLines; i++) {
+    float v = i * h;
+    GPoint a = aTop + (aBot - aTop) * v;
+    GPoint b = bTop + (bBot - bTop) * v + (R - L);
+
+    // Forward differences along u
+    GPoint p = L;
+    GPoint d = a * (h * h) + b * h;
+    GPoint dd = a * (2 * h * h);
+    int rowStart = i * numLines;
+    for (int j = 0; j < numLines; j++) {
+      verts[rowStart + j] = p;
+      p += d;
+      d += dd;
+    }
+    // Land exactly on the corners / right edge
+    verts[rowStart + n] = R;
+
+    if (tex) {
+      // Texture coordinates are bilinear in the corners: linear along each row.
+      GPoint tLeft = tex[0] + (tex[3] - tex[0]) * v;
+      GPoint tRight = tex[1] + (tex[2] - tex[1]) * v;
+      GPoint t = tLeft, dt = (tRight - tLeft) * h;
+      for (int j = 0; j < numLines; j++) {
+        texs[rowStart + j] = t;
+        t += dt;
+      }
+    }
+
+    if (i > 0) {
+      int prev = rowStart - numLines;
+      for (int j = 0; j < n; j++) {
+        indices[k++] = prev + j;
+        indices[k++] = prev + j + 1;
+        indices[k++] = rowStart + j;
+
+        indices[k++] = prev + j + 1;
+        indices[k++] = rowStart + j;
+        indices[k++] = rowStart + j + 1;
+      }
+    }
+
+    L += dL;
+    dL += ddL;
+    R += dR;
+    dR += ddR;
+  }
+  // The last row is the bottom curve; pin its ends to the corners.
+  verts[n * numLines] = pts[6];
+  verts[n * numLines + n] = pts[4];
+
+  if (tex) {
+    canvas->drawMesh(verts.data(), nullptr, texs.data(), n * n * 2, indices.data(), paint);
+  } else {
+    // No per-vertex data: every triangle is drawn with the paint as is.
+    for (int i = 0; i < k; i += 3) {
+      const GPoint tri[] = {verts[indices[i]], verts[indices[i + 1]], verts[indices[i + 2]]};
+      canvas->drawConvexPolygon(tri, 3, paint);
+    }
+  }
+}
@@ -3,6 +3,11 @@
  */
 
 #include "include/GMatrix.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 GMatrix::GMatrix() {
   fMat[0] = 1;    fMat[2] = 0;    fMat[4] = 0;
@@ -54,19 +59,70 @@ nonstd::optional<GMatrix> GMatrix::invert() const {
 }
 
 void GMatrix::mapPoints(GPoint dst[], const GPoint src[], int count) const {
-  // if GMatrix is the identity matrix, simply copy over everything from src to dst.
-  if (fMat[0] == 1 && fMat[1] == 0 && fMat[2] == 0 && fMat[3] == 1 && fMat[4] == 0 && fMat[5] == 0) {
-      for (int i = 0; i < count; i++) {
-        dst[i].x = src[i].x;
-        dst[i].y = src[i].y;
-      }
+  // Note: src and dst may be the same array, so each point (block) is read before it is written.
+  float a = fMat[0], b = fMat[1], c = fMat[2], d = fMat[3], e = fMat[4], f = fMat[5];
+  TypeMask type = this->getType();
+  if (type == kIdentity_Mask) {
+    if (dst != src) {
+      std::copy(src, src + count, dst);
+    }
+    return;
+  }
+
+  int i = 0;
+#if defined(__SSE2__)
+  // 4 points per iteration, as 2 vectors of interleaved [x0 y0 x1 y1] (same order of operations as below).
+  const float* s = reinterpret_cast<const float*>(src);
+  float* o = reinterpret_cast<float*>(dst);
+  __m128 ef = _mm_setr_ps(e, f, e, f);
+  if (type == kTranslate_Mask) {
+    for (; i + 4 <= count; i += 4) {
+      __m128 p01 = _mm_loadu_ps(s + 2*i);
+      __m128 p23 = _mm_loadu_ps(s + 2*i + 4);
+      _mm_storeu_ps(o + 2*i, _mm_add_ps(p01, ef));
+      _mm_storeu_ps(o + 2*i + 4, _mm_add_ps(p23, ef));
+    }
+  } else if (!(type & kAffine_Mask)) {
+    __m128 ad = _mm_setr_ps(a, d, a, d);
+    for (; i + 4 <= count; i += 4) {
+      __m128 p01 = _mm_loadu_ps(s + 2*i);
+      __m128 p23 = _mm_loadu_ps(s + 2*i + 4);
+      _mm_storeu_ps(o + 2*i, _mm_add_ps(_mm_mul_ps(p01, ad), ef));
+      _mm_storeu_ps(o + 2*i + 4, _mm_add_ps(_mm_mul_ps(p23, ad), ef));
+    }
+  } else {
+    __m128 ab = _mm_setr_ps(a, b, a, b);
+    __m128 cd = _mm_setr_ps(c, d, c, d);
+    for (; i + 4 <= count; i += 4) {
+      __m128 p01 = _mm_loadu_ps(s + 2*i);
+      __m128 p23 = _mm_loadu_ps(s + 2*i + 4);
+      // [x0 x0 x1 x1] and [y0 y0 y1 y1]
+      __m128 xx01 = _mm_shuffle_ps(p01, p01, _MM_SHUFFLE(2, 2, 0, 0));
+      __m128 yy01 = _mm_shuffle_ps(p01, p01, _MM_SHUFFLE(3, 3, 1, 1));
+      __m128 xx23 = _mm_shuffle_ps(p23, p23, _MM_SHUFFLE(2, 2, 0, 0));
+      __m128 yy23 = _mm_shuffle_ps(p23, p23, _MM_SHUFFLE(3, 3, 1, 1));
+      _mm_storeu_ps(o + 2*i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx01, ab), _mm_mul_ps(yy01, cd)), ef));
+      _mm_storeu_ps(o + 2*i + 4, _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx23, ab), _mm_mul_ps(yy23, cd)), ef));
+    }
+  }
+#endif
+
+  // Remaining points (all of them without SSE2)
+  if (type == kTranslate_Mask) {
+    for (; i < count; i++) {
+      dst[i] = {src[i].x + e, src[i].y + f};
+    }
+  } else if (!(type & kAffine_Mask)) {
+    for (; i < count; i++) {
+      dst[i] = {a * src[i].x + e, d * src[i].y + f};
+    }
   } else {
     float src_x, src_y;
-    for (int i = 0; i < count; i++) {
+    for (; i < count; i++) {
       src_x = src[i].x;
       src_y = src[i].y;
-      dst[i].x = fMat[0] * src_x + fMat[2] * src_y + fMat[4];
-      dst[i].y = fMat[1] * src_x + fMat[3] * src_y + fMat[5];
+      dst[i].x = a * src_x + c * src_y + e;
+      dst[i].y = b * src_x + d * src_y + f;
     }
   }
-}
\ No newline at end of file
+}
@@ -5,8 +5,8 @@
 #include "include/GPath.h"
 #include "include/GPathBuilder.h"
 
-GRect GPath::bounds() const {
-  if (fPts.size() == 0) {
+GRect GPath::computeBounds() const {
+  if (fPtCount == 0) {
     return GRect::LTRB(0, 0, 0, 0);
   }
 
@@ -19,21 +19,11 @@ GRect GPath::bounds() const {
   GPoint pts[kMaxNextPoints];
   Edger edger(*this);
 
-  GPoint p;
-  float left, right;
-  float top, bottom;
-  bool firstLoop = true;
+  GPoint p = fPts[0];
+  float left = p.x, right = p.x;
+  float top = p.y, bottom = p.y;
 
   while (auto v = edger.next(pts)) {
-    if (firstLoop) {
-      p = pts[0];
-      left = p.x;
-      right = p.x;
-      top = p.y;
-      bottom = p.y;
-      firstLoop = false;
-    }
-
     if (v.value() == GPathVerb::kMove) {
       p = pts[0];
     } else if (v.value() == GPathVerb::kLine) {
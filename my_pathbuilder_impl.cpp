@@ -5,6 +5,7 @@
 #include "include/GPathBuilder.h"
 
 void GPathBuilder::addRect(const GRect& rect, GPathDirection direction) {
+  reserve(4, 4);
   moveTo(rect.left, rect.top);
   if (direction == GPathDirection::kCW) {
     lineTo(rect.right, rect.top);
@@ -18,6 +19,7 @@ void GPathBuilder::addRect(const GRect& rect, GPathDirection direction) {
 }
 
 void GPathBuilder::addPolygon(const GPoint pts[], int count) {
+  reserve(count, count);
   moveTo(pts[0]);
   for (int i = 1; i < count; i++) {
     lineTo(pts[i]);
@@ -26,6 +28,8 @@ void GPathBuilder::addPolygon(const GPoint pts[], int count) {
 
 // Creates cubic curves.
 void GPathBuilder::addCircle(const GPoint center, float radius, GPathDirection direction) {
+  // 1 move + 4 cubics
+  reserve(13, 5);
   float x = center.x;
   float y = center.y;
 
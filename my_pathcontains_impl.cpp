@@ -0,0 +1,329 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "include/GPath.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+/*
+ * Hit testing: the path's edges are split into pieces that are monotone in both x and y. Along
+ * such a piece, y picks a single point, and the x range over a span of y is just its two ends.
+ * The pieces are sorted by top in an implicit tree that records each subtree's lowest bottom, so
+ * a query for a span of y only visits subtrees holding pieces that overlap it.
+ */
+
+namespace {
+
+struct MonoSegment {
+  GPoint pts[4];
+  int    count;      // 2 (line), 3 (quad) or 4 (cubic) points
+  float  top, bottom;
+  int    direction;  // 1 if it goes down, -1 if it goes up
+
+  GPoint eval(float t) const {
+    float s = 1 - t;
+    if (count == 2) {
+      return s * pts[0] + t * pts[1];
+    } else if (count == 3) {
+      return (s * s) * pts[0] + (2 * s * t) * pts[1] + (t * t) * pts[2];
+    }
+    return (s * s * s) * pts[0] + (3 * s * s * t) * pts[1] + (3 * s * t * t) * pts[2] + (t * t * t) * pts[3];
+  }
+
+  // x where the segment crosses y (top <= y <= bottom)
+  float xAt(float y) const {
+    GPoint a = pts[0], b = pts[count - 1];
+    if (count == 2) {
+      return (a.y == b.y) ? a.x : a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y);
+    }
+    // Monotone in y: bisect on t
+    float lo = 0, hi = 1;
+    bool increasing = b.y > a.y;
+    for (int i = 0; i < 24; i++) {
+      float mid = 0.5f * (lo + hi);
+      if ((eval(mid).y < y) == increasing) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    return eval(0.5f * (lo + hi)).x;
+  }
+};
+
+/**
+ * Appends the roots in (0, 1) of the derivative of one coordinate of a quad (3 values) or
+ * cubic (4 values).
+ */
+void addExtrema(const float v[], int count, std::vector<float>& ts) {
+  if (count == 3) {
+    float denom = v[0] - 2 * v[1] + v[2];
+    if (denom != 0) {
+      ts.push_back((v[0] - v[1]) / denom);
+    }
+  } else if (count == 4) {
+    // A t^2 + 2B t + C = 0
+    float A = -v[0] + 3 * v[1] - 3 * v[2] + v[3];
+    float B = v[0] - 2 * v[1] + v[2];
+    float C = v[1] - v[0];
+    if (A == 0) {
+      if (B != 0) {
+        ts.push_back(-C / (2 * B));
+      }
+    } else {
+      float discriminant = B * B - A * C;
+      if (discriminant >= 0) {
+        float root = sqrtf(discriminant);
+        ts.push_back((-B + root) / A);
+        ts.push_back((-B - root) / A);
+      }
+    }
+  }
+}
+
+void addMonoSegment(const GPoint pts[], int count, std::vector<MonoSegment>& segments) {
+  MonoSegment seg;
+  std::copy(pts, pts + count, seg.pts);
+  seg.count = count;
+  GPoint a = pts[0], b = pts[count - 1];
+  seg.top = std::min(a.y, b.y);
+  seg.bottom = std::max(a.y, b.y);
+  seg.direction = (b.y > a.y) ? 1 : -1;
+  segments.push_back(seg);
+}
+
+/**
+ * Chops a line / quad / cubic at its x and y extrema, appending the monotone pieces.
+ */
+void addSegment(const GPoint pts[], int count, std::vector<MonoSegment>& segments) {
+  std::vector<float> ts;
+  if (count > 2) {
+    float xs[4], ys[4];
+    for (int i = 0; i < count; i++) {
+      xs[i] = pts[i].x;
+      ys[i] = pts[i].y;
+    }
+    addExtrema(xs, count, ts);
+    addExtrema(ys, count, ts);
+    ts.erase(std::remove_if(ts.begin(), ts.end(), [](float t) { return !(t > 0 && t < 1); }), ts.end());
+    std::sort(ts.begin(), ts.end());
+    ts.erase(std::unique(ts.begin(), ts.end()), ts.end());
+  }
+
+  GPoint curr[4];
+  std::copy(pts, pts + count, curr);
+  float prevT = 0;
+  for (float t : ts) {
+    // Re-parameterize t into what is left of the curve
+    float localT = (t - prevT) / (1 - prevT);
+    prevT = t;
+    GPoint dst[7];
+    if (count == 3) {
+      GPath::ChopQuadAt(curr, dst, localT);
+      addMonoSegment(dst, 3, segments);
+      std::copy(dst + 2, dst + 5, curr);
+    } else {
+      GPath::ChopCubicAt(curr, dst, localT);
+      addMonoSegment(dst, 4, segments);
+      std::copy(dst + 3, dst + 7, curr);
+    }
+  }
+  addMonoSegment(curr, count, segments);
+}
+
+}  // namespace
+
+struct GPath::SegmentIndex {
+  std::vector<MonoSegment> segments;   // sorted by top
+  std::vector<float>       maxBottom;  // node n covers a range of segments; children 2n+1, 2n+2
+
+  enum { kLeafCount = 8 };
+
+  float build(int node, int lo, int hi) {
+    float bottom = -std::numeric_limits<float>::infinity();
+    if (hi - lo <= kLeafCount) {
+      for (int i = lo; i < hi; i++) {
+        bottom = std::max(bottom, segments[i].bottom);
+      }
+    } else {
+      int mid = (lo + hi) / 2;
+      bottom = std::max(build(2 * node + 1, lo, mid), build(2 * node + 2, mid, hi));
+    }
+    maxBottom[node] = bottom;
+    return bottom;
+  }
+
+  // Calls visit(seg) for every segment with seg.top <= bottom and seg.bottom >= top.
+  template <typename Visit> void visit(float top, float bottom, Visit&& visit) const {
+    this->visit(0, 0, (int) segments.size(), top, bottom, visit);
+  }
+
+private:
+  template <typename Visit> void visit(int node, int lo, int hi, float top, float bottom, Visit& visit) const {
+    // Sorted by top: a node whose first segment starts below the span can't reach it
+    if (lo >= hi || maxBottom[node] < top || segments[lo].top > bottom) {
+      return;
+    }
+    if (hi - lo <= kLeafCount) {
+      for (int i = lo; i < hi && segments[i].top <= bottom; i++) {
+        if (segments[i].bottom >= top) {
+          visit(segments[i]);
+        }
+      }
+    } else {
+      int mid = (lo + hi) / 2;
+      this->visit(2 * node + 1, lo, mid, top, bottom, visit);
+      this->visit(2 * node + 2, mid, hi, top, bottom, visit);
+    }
+  }
+};
+
+// Built indices, keyed by their path; ~GPath drops its entry.
+struct GPath::SegmentIndexTable {
+  std::shared_mutex mutex;
+  std::unordered_map<const GPath*, std::shared_ptr<const SegmentIndex>> indices;
+
+  static SegmentIndexTable& Get() {
+    static SegmentIndexTable* table = new SegmentIndexTable;  // never destroyed: paths may outlive statics
+    return *table;
+  }
+};
+
+// Set once any index is built, so paths that were never hit-tested skip the table when destroyed
+static std::atomic<bool> gHasSegmentIndices{false};
+
+std::shared_ptr<const GPath::SegmentIndex> GPath::segmentIndex() const {
+  SegmentIndexTable& table = SegmentIndexTable::Get();
+  {
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    auto found = table.indices.find(this);
+    if (found != table.indices.end()) {
+      return found->second;
+    }
+  }
+
+  auto index = std::make_shared<SegmentIndex>();
+  GPoint pts[kMaxNextPoints];
+  Edger edger(*this);
+  while (auto v = edger.next(pts)) {
+    addSegment(pts, v.value() + 1, index->segments);
+  }
+  std::sort(index->segments.begin(), index->segments.end(),
+            [](const MonoSegment& a, const MonoSegment& b) { return a.top < b.top; });
+  // Leaves hold more than kLeafCount / 2 segments, and a tree over L leaves needs under 4L nodes
+  index->maxBottom.resize(4 * (2 * index->segments.size() / SegmentIndex::kLeafCount + 1));
+  index->build(0, 0, (int) index->segments.size());
+
+  // Another thread may have built one meanwhile; everyone uses the first
+  std::unique_lock<std::shared_mutex> lock(table.mutex);
+  gHasSegmentIndices.store(true, std::memory_order_relaxed);
+  return table.indices.emplace(this, std::move(index)).first->second;
+}
+
+void GPath::DropSegmentIndex(const GPath* path) {
+  if (gHasSegmentIndices.load(std::memory_order_relaxed)) {
+    SegmentIndexTable& table = SegmentIndexTable::Get();
+    std::unique_lock<std::shared_mutex> lock(table.mutex);
+    table.indices.erase(path);
+  }
+}
+
+bool GPath::contains(GPoint p) const {
+  if (fPtCount == 0 || p.y < fBounds.top || p.y >= fBounds.bottom ||
+      p.x < fBounds.left || p.x >= fBounds.right) {
+    return false;
+  }
+
+  // Cast a ray to the right; each crossing adds its segment's direction.
+  int winding = 0;
+  this->segmentIndex()->visit(p.y, p.y, [&](const MonoSegment& seg) {
+    // Rows are half-open (top <= y < bottom), so shared end points count once.
+    if (seg.top <= p.y && p.y < seg.bottom && seg.xAt(p.y) > p.x) {
+      winding += seg.direction;
+    }
+  });
+  return winding != 0;
+}
+
+// y in [top, bottom] where a monotone segment crosses x (its ends must straddle x)
+static float yAtX(const MonoSegment& seg, float x, float top, float bottom) {
+  bool increasing = seg.xAt(bottom) > seg.xAt(top);
+  for (int i = 0; i < 24; i++) {
+    float mid = 0.5f * (top + bottom);
+    if ((seg.xAt(mid) < x) == increasing) {
+      top = mid;
+    } else {
+      bottom = mid;
+    }
+  }
+  return 0.5f * (top + bottom);
+}
+
+bool GPath::intersects(const GRect& r) const {
+  if (fPtCount == 0 || r.left >= r.right || r.top >= r.bottom ||
+      r.right <= fBounds.left || r.left >= fBounds.right || r.bottom <= fBounds.top || r.top >= fBounds.bottom) {
+    return false;
+  }
+  if (this->contains({0.5f * (r.left + r.right), 0.5f * (r.top + r.bottom)})) {
+    return true;
+  }
+
+  // Split the rect's rows wherever a piece starts, ends, or crosses its left or right side. In
+  // each strip the winding along those sides is then constant, and so is which pieces lie
+  // between them, so the winding along one row of the strip shows whether the interior reaches
+  // the rect there. Horizontal pieces (and coincident opposite ones) add no winding, so an edge
+  // alone never counts as a hit.
+  std::vector<const MonoSegment*> active;
+  std::vector<float> ys = {r.top, r.bottom};
+  this->segmentIndex()->visit(r.top, r.bottom, [&](const MonoSegment& seg) {
+    if (seg.top == seg.bottom) {
+      return;
+    }
+    active.push_back(&seg);
+    float top = std::max(seg.top, r.top);
+    float bottom = std::min(seg.bottom, r.bottom);
+    for (float y : {seg.top, seg.bottom}) {
+      if (y > r.top && y < r.bottom) {
+        ys.push_back(y);
+      }
+    }
+    float x0 = seg.xAt(top), x1 = seg.xAt(bottom);
+    for (float x : {r.left, r.right}) {
+      if ((x0 < x) != (x1 < x)) {
+        ys.push_back(yAtX(seg, x, top, bottom));
+      }
+    }
+  });
+  std::sort(ys.begin(), ys.end());
+
+  std::vector<std::pair<float, int>> crossings;
+  for (size_t i = 0; i + 1 < ys.size(); i++) {
+    if (!(ys[i] < ys[i + 1])) {
+      continue;
+    }
+    float y = 0.5f * (ys[i] + ys[i + 1]);
+    crossings.clear();
+    for (const MonoSegment* seg : active) {
+      if (seg->top <= y && y < seg->bottom) {
+        crossings.push_back({seg->xAt(y), seg->direction});
+      }
+    }
+    std::sort(crossings.begin(), crossings.end());
+
+    // The winding between consecutive crossings (closed contours sum to zero past the last one)
+    int winding = 0;
+    for (size_t k = 0; k + 1 < crossings.size(); k++) {
+      winding += crossings[k].second;
+      float x0 = crossings[k].first, x1 = crossings[k + 1].first;
+      if (winding != 0 && x0 < x1 && x0 < r.right && x1 > r.left) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
@@ -0,0 +1,168 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "GPathLibrary.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(GPoint) == 8, "points are stored as 2 floats");
+static_assert(sizeof(GPathVerb) == 1, "verbs are stored as 1 byte");
+
+static const char kMagic[4] = {'G', 'P', 'L', 'B'};
+
+struct Header {
+  char     magic[4];
+  uint32_t version;
+  uint32_t count;
+  uint32_t byteOrder;
+};
+
+struct Entry {
+  uint64_t pointOffset;
+  uint64_t verbOffset;
+  uint32_t pointCount;
+  uint32_t verbCount;
+  float    bounds[4];
+};
+
+static_assert(sizeof(Header) == 16, "");
+static_assert(sizeof(Entry) == 40, "");
+
+static size_t align8(size_t offset) {
+  return (offset + 7) & ~(size_t) 7;
+}
+
+std::vector<uint8_t> GPathLibrary::Serialize(const std::vector<std::shared_ptr<GPath>>& paths) {
+  // Lay out the entries, then every path's points, then every path's verbs.
+  size_t size = sizeof(Header) + paths.size() * sizeof(Entry);
+  std::vector<Entry> entries(paths.size());
+  for (size_t i = 0; i < paths.size(); i++) {
+    size = align8(size);
+    entries[i].pointOffset = size;
+    entries[i].pointCount = paths[i]->fPtCount;
+    size += paths[i]->fPtCount * sizeof(GPoint);
+  }
+  for (size_t i = 0; i < paths.size(); i++) {
+    GRect r = paths[i]->bounds();
+    entries[i].verbOffset = size;
+    entries[i].verbCount = paths[i]->fVbCount;
+    entries[i].bounds[0] = r.left;
+    entries[i].bounds[1] = r.top;
+    entries[i].bounds[2] = r.right;
+    entries[i].bounds[3] = r.bottom;
+    size += paths[i]->fVbCount;
+  }
+
+  std::vector<uint8_t> data(size, 0);
+  Header header = {{kMagic[0], kMagic[1], kMagic[2], kMagic[3]}, kVersion, (uint32_t) paths.size(),
+                   kByteOrderMark};
+  memcpy(data.data(), &header, sizeof(header));
+  if (!entries.empty()) {
+    memcpy(data.data() + sizeof(Header), entries.data(), entries.size() * sizeof(Entry));
+  }
+  for (size_t i = 0; i < paths.size(); i++) {
+    memcpy(data.data() + entries[i].pointOffset, paths[i]->fPts, entries[i].pointCount * sizeof(GPoint));
+    memcpy(data.data() + entries[i].verbOffset, paths[i]->fVbs, entries[i].verbCount);
+  }
+  return data;
+}
+
+bool GPathLibrary::Write(const char filename[], const std::vector<std::shared_ptr<GPath>>& paths) {
+  std::vector<uint8_t> data = Serialize(paths);
+  FILE* file = fopen(filename, "wb");
+  if (!file) {
+    return false;
+  }
+  bool success = fwrite(data.data(), 1, data.size(), file) == data.size();
+  return fclose(file) == 0 && success;
+}
+
+/**
+ * Checks that the entry's points and verbs lie between the entry table's end and the end of the
+ * data, that its verbs use exactly its points (so the Iter/Edger never read past them), and that
+ * its bounds are a real rect.
+ */
+static bool validEntry(const uint8_t* data, size_t tableEnd, size_t size, const Entry& e) {
+  if (e.pointOffset % 8 != 0 || e.pointOffset < tableEnd || e.pointOffset > size ||
+      e.pointCount > std::min<uint64_t>(INT_MAX, (size - e.pointOffset) / sizeof(GPoint)) ||
+      e.verbOffset < tableEnd || e.verbOffset > size ||
+      e.verbCount > std::min<uint64_t>(INT_MAX, size - e.verbOffset)) {
+    return false;
+  }
+  // Written in this order, so NaNs fail too
+  if (!(e.bounds[0] <= e.bounds[2] && e.bounds[1] <= e.bounds[3]) ||
+      !std::isfinite(e.bounds[0] - e.bounds[2]) || !std::isfinite(e.bounds[1] - e.bounds[3])) {
+    return false;
+  }
+  const GPathVerb* verbs = (const GPathVerb*) (data + e.verbOffset);
+  uint64_t points = 0;
+  for (uint32_t i = 0; i < e.verbCount; i++) {
+    if (verbs[i] > kCubic || (i == 0 && verbs[i] != kMove)) {
+      return false;
+    }
+    points += (verbs[i] == kMove) ? 1 : verbs[i];  // kLine, kQuad, kCubic add 1, 2, 3 points
+  }
+  return points == e.pointCount;
+}
+
+std::shared_ptr<GPathLibrary> GPathLibrary::Make(const void* data, size_t size, std::shared_ptr<const void> owner) {
+  Header header;
+  if (!data || size < sizeof(Header) || (uintptr_t) data % 8 != 0) {
+    return nullptr;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, kMagic, 4) != 0 || header.version != kVersion ||
+      header.byteOrder != kByteOrderMark || header.count > INT_MAX ||
+      (size - sizeof(Header)) / sizeof(Entry) < header.count) {
+    return nullptr;
+  }
+
+  const uint8_t* bytes = (const uint8_t*) data;
+  const Entry* entries = (const Entry*) (bytes + sizeof(Header));
+  const size_t tableEnd = sizeof(Header) + header.count * sizeof(Entry);
+  for (uint32_t i = 0; i < header.count; i++) {
+    if (!validEntry(bytes, tableEnd, size, entries[i])) {
+      return nullptr;
+    }
+  }
+  return std::shared_ptr<GPathLibrary>(new GPathLibrary(bytes, header.count, std::move(owner)));
+}
+
+std::shared_ptr<GPathLibrary> GPathLibrary::Map(const char filename[]) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(Header)) {
+    close(fd);
+    return nullptr;
+  }
+  size_t size = st.st_size;
+  void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // the mapping stays valid
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+
+  std::shared_ptr<const void> mapping(addr, [size](const void* p) { munmap(const_cast<void*>(p), size); });
+  return Make(addr, size, std::move(mapping));
+}
+
+std::shared_ptr<GPath> GPathLibrary::path(int index) const {
+  if (index < 0 || index >= fCount) {
+    return nullptr;
+  }
+  const Entry& e = ((const Entry*) (fData + sizeof(Header)))[index];
+  return GPath::MakeExternal((const GPoint*) (fData + e.pointOffset), (int) e.pointCount,
+                             (const GPathVerb*) (fData + e.verbOffset), (int) e.verbCount,
+                             GRect::LTRB(e.bounds[0], e.bounds[1], e.bounds[2], e.bounds[3]), fOwner);
+}
@@ -0,0 +1,151 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "GPicture.h"
+#include <algorithm>
+#include <cmath>
+
+void GPicture::playback(GCanvas* canvas, float top, float bottom) const {
+  for (const Op& op : fOps) {
+    if (op.bottom > top && op.top < bottom) {
+      op.proc(canvas);
+    }
+  }
+  for (int i = 0; i < fOpenSaves; i++) {
+    canvas->restore();
+  }
+}
+
+GRecordingCanvas::GRecordingCanvas() : fPicture(std::make_shared<GPicture>()), fMatrixStack(1) {}
+
+std::shared_ptr<GPicture> GRecordingCanvas::finish() {
+  std::shared_ptr<GPicture> picture = std::move(fPicture);
+  fPicture = std::make_shared<GPicture>();
+  fMatrixStack.assign(1, GMatrix());
+  return picture;
+}
+
+void GRecordingCanvas::addState(std::function<void(GCanvas*)> proc) {
+  const float inf = std::numeric_limits<float>::infinity();
+  fPicture->fOps.push_back({-inf, inf, std::move(proc)});
+}
+
+void GRecordingCanvas::addDraw(const GPoint pts[], int count, std::function<void(GCanvas*)> proc) {
+  // Rows reached by the mapped points, widened by a pixel for rounding (and anti-aliasing-free
+  // centers) at the edges. NaN coordinates compare false and so keep the draw unbounded.
+  float top = std::numeric_limits<float>::infinity();
+  float bottom = -top;
+  std::vector<GPoint> mapped(pts, pts + count);
+  fMatrixStack.back().mapPoints(mapped.data(), count);
+  for (const GPoint& p : mapped) {
+    top = std::min(top, p.y);
+    bottom = std::max(bottom, p.y);
+  }
+  if (std::isnan(top) || std::isnan(bottom)) {
+    top = -std::numeric_limits<float>::infinity();
+    bottom = std::numeric_limits<float>::infinity();
+  }
+  fPicture->fOps.push_back({top - 1, bottom + 1, std::move(proc)});
+}
+
+void GRecordingCanvas::save() {
+  fMatrixStack.push_back(fMatrixStack.back());
+  fPicture->fOpenSaves += 1;
+  this->addState([](GCanvas* canvas) { canvas->save(); });
+}
+
+void GRecordingCanvas::restore() {
+  // An unmatched restore would empty the real canvas's stack, so it isn't recorded
+  if (fMatrixStack.size() > 1) {
+    fMatrixStack.pop_back();
+    fPicture->fOpenSaves -= 1;
+    this->addState([](GCanvas* canvas) { canvas->restore(); });
+  }
+}
+
+void GRecordingCanvas::concat(const GMatrix& matrix) {
+  fMatrixStack.back() = fMatrixStack.back() * matrix;
+  this->addState([matrix](GCanvas* canvas) { canvas->concat(matrix); });
+}
+
+void GRecordingCanvas::clear(const GColor& color) {
+  this->addState([color](GCanvas* canvas) { canvas->clear(color); });
+}
+
+void GRecordingCanvas::drawRect(const GRect& rect, const GPaint& paint) {
+  GPoint corners[4] = {{rect.left, rect.top}, {rect.right, rect.top},
+                       {rect.right, rect.bottom}, {rect.left, rect.bottom}};
+  this->addDraw(corners, 4, [rect, paint](GCanvas* canvas) { canvas->drawRect(rect, paint); });
+}
+
+void GRecordingCanvas::drawConvexPolygon(const GPoint pts[], int count, const GPaint& paint) {
+  std::vector<GPoint> points(pts, pts + std::max(count, 0));
+  this->addDraw(pts, count, [points = std::move(points), paint](GCanvas* canvas) {
+    canvas->drawConvexPolygon(points.data(), (int) points.size(), paint);
+  });
+}
+
+void GRecordingCanvas::drawPath(const GPath& path, const GPaint& paint) {
+  // Paths are immutable and always shared-owned, so the recording can just share this one
+  std::shared_ptr<const GPath> shared = path.shared_from_this();
+  GRect b = path.bounds();
+  GPoint corners[4] = {{b.left, b.top}, {b.right, b.top}, {b.right, b.bottom}, {b.left, b.bottom}};
+  this->addDraw(corners, 4, [shared, paint](GCanvas* canvas) { canvas->drawPath(*shared, paint); });
+}
+
+void GRecordingCanvas::drawStrokePolygon(const GPoint pts[], int count, float width, bool isClosed,
+                                         const GPaint& paint) {
+  if (count < 1) {
+    return;
+  }
+  // The stroke stays within half its width of the polygon's bounds
+  GRect b = GRect::LTRB(pts[0].x, pts[0].y, pts[0].x, pts[0].y);
+  for (int i = 1; i < count; i++) {
+    b = GRect::LTRB(std::min(b.left, pts[i].x), std::min(b.top, pts[i].y),
+                    std::max(b.right, pts[i].x), std::max(b.bottom, pts[i].y));
+  }
+  const float r = std::max(width, 0.f) * 0.5f;
+  GPoint corners[4] = {{b.left - r, b.top - r}, {b.right + r, b.top - r},
+                       {b.right + r, b.bottom + r}, {b.left - r, b.bottom + r}};
+  std::vector<GPoint> points(pts, pts + count);
+  this->addDraw(corners, 4, [points = std::move(points), width, isClosed, paint](GCanvas* canvas) {
+    canvas->drawStrokePolygon(points.data(), (int) points.size(), width, isClosed, paint);
+  });
+}
+
+void GRecordingCanvas::drawMesh(const GPoint verts[], const GColor colors[], const GPoint texs[],
+                                int count, const int indices[], const GPaint& paint) {
+  if (count <= 0) {
+    return;
+  }
+  int vertexCount = 3 * count;
+  std::vector<int> ids;
+  if (indices) {
+    ids.assign(indices, indices + 3 * count);
+    vertexCount = *std::max_element(ids.begin(), ids.end()) + 1;
+  }
+  std::vector<GPoint> v(verts, verts + vertexCount);
+  std::vector<GColor> c = colors ? std::vector<GColor>(colors, colors + vertexCount) : std::vector<GColor>();
+  std::vector<GPoint> t = texs ? std::vector<GPoint>(texs, texs + vertexCount) : std::vector<GPoint>();
+  this->addDraw(verts, vertexCount, [v, c, t, ids, count, paint](GCanvas* canvas) {
+    canvas->drawMesh(v.data(), c.empty() ? nullptr : c.data(), t.empty() ? nullptr : t.data(), count,
+                     ids.empty() ? nullptr : ids.data(), paint);
+  });
+}
+
+void GRecordingCanvas::drawQuad(const GPoint verts[4], const GColor colors[4], const GPoint texs[4],
+                                int level, const GPaint& paint) {
+  struct Quad {
+    GPoint verts[4];
+    GColor colors[4];
+    GPoint texs[4];
+  } q;
+  std::copy(verts, verts + 4, q.verts);
+  if (colors) std::copy(colors, colors + 4, q.colors);
+  if (texs) std::copy(texs, texs + 4, q.texs);
+  const bool hasColors = colors != nullptr, hasTexs = texs != nullptr;
+  this->addDraw(verts, 4, [q, hasColors, hasTexs, level, paint](GCanvas* canvas) {
+    canvas->drawQuad(q.verts, hasColors ? q.colors : nullptr, hasTexs ? q.texs : nullptr, level, paint);
+  });
+}
@@ -12,6 +12,13 @@ std::shared_ptr<GShader> GCreateBitmapShader(const GBitmap& bitmap, const GMatri
   return std::make_shared<GShader_Bitmap>(bitmap, localMatrix, tileMode);
 }
 
+std::shared_ptr<GShader> GCreateBitmapShader(std::shared_ptr<const GBitmap> bitmap, const GMatrix& localMatrix, GTileMode tileMode) {
+  if (!bitmap) {
+    return nullptr;
+  }
+  return std::make_shared<GShader_Bitmap>(*bitmap, localMatrix, tileMode, bitmap);
+}
+
 std::shared_ptr<GShader> GCreateLinearGradient(GPoint p0, GPoint p1, const GColor colors[], int count, GTileMode tileMode) {
   if (count == 1) {
     return std::make_shared<GShader_Gradient1>(p0, p1, colors, count);
@@ -0,0 +1,188 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "GStroker.h"
+#include "include/GCanvas.h"
+
+#include <vector>
+
+// Max distance (in device pixels) between a quadratic arc and the true circle.
+static const float kArcTolerance = 0.1f;
+
+// A path may be drawn at any scale, so a GPath never uses fewer arcs per circle than this.
+static const int kMinPathArcs = 8;
+static const int kMaxArcs = 64;
+
+/**
+ * Returns the number of quadratic arcs needed for a full circle of the given radius, measured in
+ * device pixels.
+ */
+static int arc_count(float deviceRadius) {
+  /* A quadratic arc spanning 2*phi (control point at radius / cos(phi)) bulges out the most at its
+   * midpoint, which is at radius * (cos(phi) + 1/cos(phi)) / 2.
+   */
+  int arcs = 4;
+  while (arcs < kMaxArcs) {
+    float phi = gFloatPI / arcs;
+    float error = deviceRadius * (0.5f*cosf(phi) + 0.5f/cosf(phi) - 1.f);
+    if (error <= kArcTolerance) {
+      break;
+    }
+    arcs *= 2;
+  }
+  return arcs;
+}
+
+/**
+ * Appends quadratic arcs around center from startAngle, sweeping (increasing) by sweep radians.
+ * Assumes the current point is already at startAngle.
+ */
+static void addArcs(GStrokeSink* sink, GPoint center, float radius, float startAngle, float sweep, int arcs) {
+  float step = sweep / arcs;
+  float controlRadius = radius / cosf(step * 0.5f);
+  for (int i = 0; i < arcs; i++) {
+    float controlAngle = startAngle + (i + 0.5f) * step;
+    float endAngle = startAngle + (i + 1) * step;
+    sink->quadTo({center.x + controlRadius * cosf(controlAngle), center.y + controlRadius * sinf(controlAngle)},
+                 {center.x + radius * cosf(endAngle), center.y + radius * sinf(endAngle)});
+  }
+}
+
+/**
+ * Continues the side of the stroke that is offset by u0 from p onto the side offset by u1, where
+ * turn is the signed angle from u0 to u1. Turning outward leaves a gap, filled with an arc;
+ * turning inward, the two sides cross, and going through p keeps the winding right.
+ */
+static void addJoin(GStrokeSink* sink, GPoint p, GPoint u0, GPoint u1, float turn, float radius, int circleArcs) {
+  if (turn > 0.f) {
+    int arcs = std::max(1, (int) ceilf(circleArcs * turn / (2.f * gFloatPI)));
+    addArcs(sink, p, radius, atan2f(u0.y, u0.x), turn, arcs);
+  } else if (turn < 0.f) {
+    sink->lineTo(p);
+    sink->lineTo(p + u1);
+  }
+}
+
+static void addDisk(GStrokeSink* sink, GPoint center, float radius, int circleArcs) {
+  sink->moveTo({center.x + radius, center.y});
+  addArcs(sink, center, radius, 0.f, 2.f * gFloatPI, circleArcs);
+}
+
+/**
+ * GStrokeOutline(), with round pieces made of circleArcs quadratic arcs per full circle.
+ */
+static void strokeOutline(const GPoint src[], int count, float width, bool isClosed, int circleArcs,
+                          GStrokeSink* sink) {
+  // Repeated points make zero-length segments, which have no direction
+  std::vector<GPoint> pts;
+  for (int i = 0; i < count; i++) {
+    if (pts.empty() || src[i] != pts.back()) {
+      pts.push_back(src[i]);
+    }
+  }
+  if (isClosed && pts.size() > 1 && pts.front() == pts.back()) {
+    pts.pop_back();
+  }
+
+  float radius = width * 0.5f;
+  int n = (int) pts.size();
+  if (n == 1) {
+    addDisk(sink, pts[0], radius, circleArcs);
+    return;
+  }
+
+  // Per segment (pts[i] -> pts[i + 1]): its normal (rotated +90 degrees, radius long) and length
+  int segmentCount = isClosed ? n : n - 1;
+  std::vector<GPoint> normals(segmentCount);
+  std::vector<float> lengths(segmentCount);
+  for (int i = 0; i < segmentCount; i++) {
+    GPoint d = pts[(i + 1) % n] - pts[i];
+    lengths[i] = d.length();
+    normals[i] = {-d.y * radius / lengths[i], d.x * radius / lengths[i]};
+  }
+
+  // Per vertex: the signed turn from the segment into it to the segment out of it (0 at the ends)
+  std::vector<float> turns(n, 0.f);
+  for (int i = 0; i < n; i++) {
+    if (isClosed || (i > 0 && i < n - 1)) {
+      GPoint d0 = pts[i] - pts[(i + n - 1) % n];
+      GPoint d1 = pts[(i + 1) % n] - pts[i];
+      turns[i] = atan2f(d0.x * d1.y - d0.y * d1.x, d0.x * d1.x + d0.y * d1.y);
+    }
+  }
+
+  // Right side (-normal) forward, then left side (+normal) backward. Open polygons join them
+  // with caps into a single contour.
+  sink->reserve(4 * n + 2 * circleArcs, 2 * n + circleArcs);
+  sink->moveTo(pts[0] - normals[0]);
+  for (int i = 0; i < segmentCount; i++) {
+    int v = (i + 1) % n;
+    sink->lineTo(pts[v] - normals[i]);
+    if (isClosed || v < n - 1) {
+      int next = (i + 1) % segmentCount;
+      addJoin(sink, pts[v], -1 * normals[i], -1 * normals[next], turns[v], radius, circleArcs);
+    }
+  }
+  if (isClosed) {
+    sink->moveTo(pts[0] + normals[segmentCount - 1]);
+  } else {
+    GPoint u = -1 * normals[segmentCount - 1];
+    addArcs(sink, pts[n - 1], radius, atan2f(u.y, u.x), gFloatPI, circleArcs / 2);
+  }
+  for (int i = segmentCount - 1; i >= 0; i--) {
+    sink->lineTo(pts[i] + normals[i]);
+    if (isClosed || i > 0) {
+      int prev = (i + segmentCount - 1) % segmentCount;
+      addJoin(sink, pts[i], normals[i], normals[prev], -turns[i], radius, circleArcs);
+    }
+  }
+  if (!isClosed) {
+    addArcs(sink, pts[0], radius, atan2f(normals[0].y, normals[0].x), gFloatPI, circleArcs / 2);
+  }
+
+  // Past the end of a short segment, the outline can cut into the disk at its vertex
+  for (int i = 0; i < n; i++) {
+    bool shortIn = (isClosed || i > 0) && lengths[(i + segmentCount - 1) % segmentCount] < radius;
+    bool shortOut = (isClosed || i < n - 1) && lengths[i % segmentCount] < radius;
+    if (shortIn || shortOut) {
+      addDisk(sink, pts[i], radius, circleArcs);
+    }
+  }
+}
+
+namespace {
+
+// Builds the outline as a path.
+class PathStrokeSink : public GStrokeSink {
+public:
+  void reserve(int extraPoints, int extraVerbs) override { fBuilder.reserve(extraPoints, extraVerbs); }
+  void moveTo(GPoint p) override { fBuilder.moveTo(p); }
+  void lineTo(GPoint p) override { fBuilder.lineTo(p); }
+  void quadTo(GPoint p1, GPoint p2) override { fBuilder.quadTo(p1, p2); }
+
+  GPathBuilder fBuilder;
+};
+
+}  // namespace
+
+void GStrokeOutline(const GPoint pts[], int count, float width, bool isClosed, float unitsPerPixel,
+                    GStrokeSink* sink) {
+  if (count < 2 || width <= 0.f) {
+    return;
+  }
+  strokeOutline(pts, count, width, isClosed, arc_count(width * 0.5f / unitsPerPixel), sink);
+}
+
+std::shared_ptr<GPath> GStrokePolygon(const GPoint pts[], int count, float width, bool isClosed) {
+  if (count < 2 || width <= 0.f) {
+    return nullptr;
+  }
+  PathStrokeSink sink;
+  strokeOutline(pts, count, width, isClosed, std::max(arc_count(width * 0.5f), kMinPathArcs), &sink);
+  return sink.fBuilder.detach();
+}
+
+void GCanvas::drawStrokePolygon(const GPoint pts[], int count, float width, bool isClosed, const GPaint& paint) {
+  this->drawPath(GStrokePolygon(pts, count, width, isClosed), paint);
+}
@@ -3,6 +3,12 @@
  */
 
 #include "../include/GBitmap.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 void GBitmap::setIsOpaque(IsOpaque io) {
     switch (io) {
@@ -17,15 +23,31 @@ void GBitmap::reset(int w, int h, size_t rb, GPixel* pixels, IsOpaque io) {
     fHeight = h;
     fRowBytes = rb;
     fPixels = pixels;
+    fIsMapped = false;
     this->setIsOpaque(io);
     this->validate();
 }
 
 bool GBitmap::ComputeIsOpaque(const GBitmap& bm) {
+    const GPixel kAlphaMask = 0xFFu << GPIXEL_SHIFT_A;
+    const int w = bm.width();
     for (int y = 0; y < bm.height(); ++y) {
         const GPixel* row = bm.getAddr(0, y);
-        for (int x = 0; x < bm.width(); ++x) {
-            if (GPixel_GetA(row[x]) != 0xFF) {
+        int x = 0;
+#if defined(__SSE2__)
+        // AND 8 pixels together; they are all opaque iff every alpha bit survives
+        const __m128i mask = _mm_set1_epi32((int)kAlphaMask);
+        for (; x + 8 <= w; x += 8) {
+            __m128i all = _mm_and_si128(_mm_loadu_si128((const __m128i*)(row + x)),
+                                        _mm_loadu_si128((const __m128i*)(row + x + 4)));
+            all = _mm_cmpeq_epi32(_mm_and_si128(all, mask), mask);
+            if (_mm_movemask_epi8(all) != 0xFFFF) {
+                return false;
+            }
+        }
+#endif
+        for (; x < w; ++x) {
+            if ((row[x] & kAlphaMask) != kAlphaMask) {
                 return false;
             }
         }
@@ -47,3 +69,30 @@ void GBitmap::alloc(int w, int h, size_t rb) {
                 (w > 0 && h > 0) ? (GPixel*)calloc(h, rb) : nullptr,
                 kNo_IsOpaque);
 }
+
+void GBitmap::alloc(int w, int h, AllocFlags flags) {
+    assert(w >= 0);
+    assert(h >= 0);
+    size_t rb = w * sizeof(GPixel);
+    if (flags & kAligned_AllocFlag) {
+        rb = (rb + kAllocAlignment - 1) & ~(kAllocAlignment - 1);
+    }
+
+    GPixel* pixels = nullptr;
+    if (w > 0 && h > 0) {
+        const size_t size = rb * h;
+        if (flags & kAligned_AllocFlag) {
+            // posix_memalign memory is released by free(), like calloc's
+            void* addr;
+            if (posix_memalign(&addr, kAllocAlignment, size) == 0) {
+                pixels = (GPixel*)addr;
+                if (!(flags & kUninitialized_AllocFlag)) {
+                    memset(pixels, 0, size);
+                }
+            }
+        } else {
+            pixels = (GPixel*)((flags & kUninitialized_AllocFlag) ? malloc(size) : calloc(h, rb));
+        }
+    }
+    this->reset(w, h, rb, pixels, kNo_IsOpaque);
+}
@@ -3,67 +3,474 @@
  */
 
 #include "../include/GBitmap.h"
+#include "../include/GPNGWriter.h"
+#include "../include/GPixelConvert.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include "GImageFormats.h"
 #include "lodepng.h"
 
-static void convertToPNG(const GPixel src[], int width, uint8_t dst[]) {
-    for (int i = 0; i < width; i++) {
-        GPixel c = *src++;
-        int a = GPixel_GetA(c);
-        int r = GPixel_GetR(c);
-        int g = GPixel_GetG(c);
-        int b = GPixel_GetB(c);
-        
-        // PNG requires unpremultiplied, but GPixel is premultiplied
-        if (0 != a && 255 != a) {
-            r = (r * 255 + a/2) / a;
-            g = (g * 255 + a/2) / a;
-            b = (b * 255 + a/2) / a;
-        }
-        *dst++ = r;
-        *dst++ = g;
-        *dst++ = b;
-        *dst++ = a;
-    }
-}
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 bool GBitmap::writeToFile(const char path[]) const {
-    size_t rb = this->width() * 4;
-    uint8_t* pix = (uint8_t*)malloc(this->height() * rb);
-    if (!pix) {
-        return false;
+    return this->writeToFile(path, GPNGOptions());
+}
+
+bool GBitmap::writeToFile(const char path[], const GPNGOptions& options) const {
+    switch (GImageFormatForPath(path)) {
+        case GImageFormat::kQOI: return GWriteQOI(*this, path);
+        case GImageFormat::kPAM: return GWritePAM(*this, path);
+        case GImageFormat::kPNG: break;
     }
 
+    GPNGWriter writer;
+    if (!writer.begin(path, this->width(), this->height(), options)) {
+        return false;
+    }
     const GPixel* src = this->pixels();
-    uint8_t* dst = pix;
     for (int y = 0; y < this->height(); ++y) {
-        convertToPNG(src, this->width(), dst);
+        writer.writeRow(src);
         src += this->rowBytes() / 4;
-        dst += rb;
     }
+    return writer.finish();
+}
 
-    unsigned err = lodepng_encode32_file(path, pix, this->width(), this->height());
-    free(pix);
-    return err == 0;
+///////////////////////////////////////////////////////////////////////////////
+
+static void put32(std::vector<uint8_t>& v, unsigned x) {
+    v.push_back(x >> 24);
+    v.push_back(x >> 16);
+    v.push_back(x >> 8);
+    v.push_back(x);
+}
+
+GPNGWriter::~GPNGWriter() {
+    if (fFile) {
+        fclose(fFile);
+    }
+}
+
+bool GPNGWriter::writeChunk(const char type[4], const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    chunk.reserve(data.size() + 12);
+    put32(chunk, (unsigned) data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    put32(chunk, lodepng_crc32(chunk.data() + 4, data.size() + 4));  // crc of type + data
+    fOK = fOK && fwrite(chunk.data(), 1, chunk.size(), fFile) == chunk.size();
+    return fOK;
+}
+
+bool GPNGWriter::begin(const char path[], int width, int height, const GPNGOptions& options) {
+    fFile = fopen(path, "wb");
+    fOK = fFile != nullptr && width > 0 && height > 0;
+    if (!fOK) {
+        return false;
+    }
+    fWidth = width;
+    fHeight = height;
+    fOptions = options;
+    // Each chunk in flight holds a thread, so never run more of them than the hardware has
+    const int hardwareThreads = std::max((int) std::thread::hardware_concurrency(), 1);
+    if (fOptions.fThreads <= 0 || fOptions.fThreads > hardwareThreads) {
+        fOptions.fThreads = hardwareThreads;
+    }
+    fChunkBytes = fOptions.fThreads > 1 ? kParallelChunkBytes : kChunkBytes;
+    fPrevRow.assign(width * 4, 0);   // the row above the first one counts as zeros
+    fCurrRow.resize(width * 4);
+    fCandidates.resize(5 * (width * 4 + 1));
+
+    static const uint8_t kSignature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    fOK = fwrite(kSignature, 1, 8, fFile) == 8;
+
+    // 8-bit RGBA, no interlace
+    std::vector<uint8_t> ihdr;
+    put32(ihdr, width);
+    put32(ihdr, height);
+    ihdr.insert(ihdr.end(), {8, 6, 0, 0, 0});
+    return this->writeChunk("IHDR", ihdr);
+}
+
+static uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+bool GPNGWriter::writeRow(const GPixel row[]) {
+    if (!fOK || fRowsWritten >= fHeight) {
+        return fOK = false;
+    }
+    GConvertPremulToRGBA(row, fWidth, fCurrRow.data());
+
+    /* Try the filters and keep the one with the smallest sum of (signed) bytes, the same heuristic
+     * lodepng uses for RGBA by default. The fast preset only tries Sub and Up, which are cheap and
+     * catch most of what the others would on rendered images.
+     */
+    const size_t n = fWidth * 4;
+    const uint8_t* x = fCurrRow.data();
+    const uint8_t* up = fPrevRow.data();
+    const int firstType = fOptions.fFast ? 1 : 0;
+    const int endType = fOptions.fFast ? 3 : 5;
+    int best = firstType;
+    size_t bestSum = SIZE_MAX;
+    for (int type = firstType; type < endType; type++) {
+        uint8_t* out = fCandidates.data() + type * (n + 1);
+        out[0] = type;
+        size_t sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            int a = i >= 4 ? x[i - 4] : 0;
+            int b = up[i];
+            int c = i >= 4 ? up[i - 4] : 0;
+            uint8_t v = x[i];
+            switch (type) {
+                case 1: v -= a; break;
+                case 2: v -= b; break;
+                case 3: v -= (a + b) >> 1; break;
+                case 4: v -= paeth(a, b, c); break;
+            }
+            out[i + 1] = v;
+            sum += v < 128 ? v : 256 - v;
+        }
+        if (sum < bestSum) {
+            bestSum = sum;
+            best = type;
+        }
+    }
+    const uint8_t* chosen = fCandidates.data() + best * (n + 1);
+    fFiltered.insert(fFiltered.end(), chosen, chosen + n + 1);
+    fPrevRow.swap(fCurrRow);
+    fRowsWritten += 1;
+
+    if (fFiltered.size() >= fChunkBytes) {
+        return this->flush(false);
+    }
+    return fOK;
+}
+
+// Greedy matching over a short window: about 2.5x faster than the defaults for ~6% more bytes
+static const LodePNGCompressSettings gFastCompressSettings = {
+    2, 1, 512, 3, 32, 0, nullptr, nullptr, nullptr
+};
+
+static std::vector<uint8_t> deflate_chunk(std::vector<uint8_t> data, const LodePNGCompressSettings* settings,
+                                          bool last) {
+    unsigned char* deflated = nullptr;
+    size_t deflatedSize = 0;
+    std::vector<uint8_t> result;
+    if (!lodepng_deflate_chunk(&deflated, &deflatedSize, data.data(), data.size(), settings, last)) {
+        result.assign(deflated, deflated + deflatedSize);
+    }
+    free(deflated);
+    return result;
+}
+
+bool GPNGWriter::flush(bool last) {
+    fAdler = lodepng_adler32_update(fAdler, fFiltered.data(), fFiltered.size());
+
+    /* Every chunk ends on a byte boundary (a sync-flush block, or the final block), so chunks can be
+     * deflated on their own and simply concatenated. With threads, up to fThreads of them are in
+     * flight at once: once that many are pending, we wait on the oldest and write it before
+     * queueing more, so they still go out in order.
+     */
+    const LodePNGCompressSettings* settings = fOptions.fFast ? &gFastCompressSettings
+                                                             : &lodepng_default_compress_settings;
+    auto policy = fOptions.fThreads > 1 ? std::launch::async : std::launch::deferred;
+    fPending.push_back(std::async(policy, deflate_chunk, std::move(fFiltered), settings, last));
+    fFiltered = std::vector<uint8_t>();
+    fFiltered.reserve(fChunkBytes + fWidth * 4 + 1);
+
+    const size_t keep = last ? 0 : fOptions.fThreads - 1;
+    while (fPending.size() > keep) {
+        this->writeNextIDAT(last && fPending.size() == 1);
+    }
+    return fOK;
+}
+
+bool GPNGWriter::writeNextIDAT(bool appendAdler) {
+    Deflated deflated = fPending.front().get();
+    fPending.pop_front();
+    fOK = fOK && !deflated.empty();
+
+    std::vector<uint8_t> idat;
+    if (!fStarted) {
+        // zlib header: deflate with a 32K window, no dictionary
+        idat.insert(idat.end(), {0x78, 0x01});
+        fStarted = true;
+    }
+    idat.insert(idat.end(), deflated.begin(), deflated.end());
+    if (appendAdler) {
+        put32(idat, fAdler);
+    }
+    return fOK && this->writeChunk("IDAT", idat);
+}
+
+bool GPNGWriter::finish() {
+    if (!fFile) {
+        return false;
+    }
+    if (fOK && fRowsWritten == fHeight) {
+        this->flush(true);
+        this->writeChunk("IEND", {});
+    } else {
+        fOK = false;
+    }
+    fOK = (fclose(fFile) == 0) && fOK;
+    fFile = nullptr;
+    return fOK;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static int alpha_mul(unsigned a, unsigned c) {
-    return (a * c + 127) / 255;
+static unsigned read32(const uint8_t p[]) {
+    return ((unsigned) p[0] << 24) | ((unsigned) p[1] << 16) | ((unsigned) p[2] << 8) | p[3];
+}
+
+#if defined(__SSE2__)
+static inline __m128i load_pixel(const uint8_t p[]) {
+    int32_t v;
+    memcpy(&v, p, 4);
+    return _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), _mm_setzero_si128());
+}
+
+static inline void store_pixel(uint8_t p[], __m128i v) {
+    int32_t out = _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+    memcpy(p, &out, 4);
+}
+
+static inline __m128i abs_epi16(__m128i x) {
+    return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/*
+ *  Sub, Average and Paeth on RGBA rows, one pixel (4 x 16-bit lanes) at a time: each pixel depends
+ *  on the one before it, but its 4 channels are independent.
+ */
+static void unfilter_row_rgba(uint8_t out[], const uint8_t in[], const uint8_t prev[], int filter,
+                              size_t len) {
+    const __m128i mask = _mm_set1_epi16(0xFF);
+    __m128i a = _mm_setzero_si128();  // left
+    __m128i c = _mm_setzero_si128();  // up-left
+    for (size_t i = 0; i < len; i += 4) {
+        __m128i x = load_pixel(in + i);
+        __m128i d;
+        if (filter == 1) {
+            d = _mm_add_epi16(x, a);
+        } else if (filter == 3) {
+            __m128i b = load_pixel(prev + i);
+            d = _mm_add_epi16(x, _mm_srli_epi16(_mm_add_epi16(a, b), 1));
+        } else {
+            // Paeth: the neighbor closest to a + b - c, preferring a, then b
+            __m128i b = load_pixel(prev + i);
+            __m128i pa = _mm_sub_epi16(b, c);  // p - a
+            __m128i pb = _mm_sub_epi16(a, c);  // p - b
+            __m128i pc = abs_epi16(_mm_add_epi16(pa, pb));
+            pa = abs_epi16(pa);
+            pb = abs_epi16(pb);
+            __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+            __m128i nearest = select(_mm_cmpeq_epi16(pa, smallest), a,
+                                     select(_mm_cmpeq_epi16(pb, smallest), b, c));
+            d = _mm_add_epi16(x, nearest);
+            c = b;
+        }
+        a = _mm_and_si128(d, mask);
+        store_pixel(out + i, a);
+    }
+}
+#endif
+
+// Reverses one PNG scanline filter: out = in + predictor(left, up, upLeft). prev is the row above.
+static void unfilter_row(uint8_t out[], const uint8_t in[], const uint8_t prev[], int filter,
+                         size_t len, int bpp) {
+#if defined(__SSE2__)
+    if (bpp == 4 && (filter == 1 || filter == 3 || filter == 4)) {
+        unfilter_row_rgba(out, in, prev, filter, len);
+        return;
+    }
+#endif
+    size_t i = 0;
+    switch (filter) {
+        case 0:
+            memcpy(out, in, len);
+            break;
+        case 1:
+            for (; i < (size_t) bpp; i++) out[i] = in[i];
+            for (; i < len; i++) out[i] = in[i] + out[i - bpp];
+            break;
+        case 2:
+            for (; i < len; i++) out[i] = in[i] + prev[i];
+            break;
+        case 3:
+            for (; i < (size_t) bpp; i++) out[i] = in[i] + (prev[i] >> 1);
+            for (; i < len; i++) out[i] = in[i] + ((out[i - bpp] + prev[i]) >> 1);
+            break;
+        case 4:
+            for (; i < (size_t) bpp; i++) out[i] = in[i] + prev[i];
+            for (; i < len; i++) out[i] = in[i] + paeth(out[i - bpp], prev[i], prev[i - bpp]);
+            break;
+    }
 }
 
-static void swizzle_rgba_row(GPixel dst[], const uint8_t src[], int count) {
-    for (int i = 0; i < count; ++i) {
-        unsigned a = src[3];
-        dst[i] = GPixel_PackARGB(a,
-                                 alpha_mul(a, src[0]),
-                                 alpha_mul(a, src[1]),
-                                 alpha_mul(a, src[2]));
-        src += 4;
+enum class DirectDecode { kOK, kUnsupported, kError };
+
+/*
+ *  Decodes 8-bit RGBA and RGB, non-interlaced PNGs (everything we write, and most textures) straight
+ *  into bm. IDAT data is inflated into one buffer that becomes the pixel memory: each scanline is
+ *  unfiltered into a scratch row and converted back into the same buffer, which never overtakes
+ *  the filtered data still to be read. Opacity is found during the conversion.
+ *
+ *  Returns kUnsupported, leaving bm alone, for other formats.
+ */
+static DirectDecode read_png_direct(const char path[], GBitmap* bm) {
+    unsigned char* file = nullptr;
+    size_t fileSize = 0;
+    if (lodepng_load_file(&file, &fileSize, path)) {
+        free(file);
+        return DirectDecode::kError;
+    }
+    std::unique_ptr<unsigned char, decltype(&free)> fileOwner(file, &free);
+
+    static const uint8_t kSignature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    if (fileSize < 33 || memcmp(file, kSignature, 8) || memcmp(file + 12, "IHDR", 4)) {
+        return DirectDecode::kUnsupported;   // let lodepng report the error
+    }
+    const unsigned w = read32(file + 16), h = read32(file + 20);
+    const uint8_t* ihdr = file + 24;  // bit depth, color type, compression, filter, interlace
+    if (ihdr[0] != 8 || (ihdr[1] != 2 && ihdr[1] != 6) || ihdr[2] || ihdr[3] || ihdr[4] ||
+        w == 0 || h == 0 || w > (1 << 24) || h > (1 << 24)) {
+        return DirectDecode::kUnsupported;
+    }
+    const int bpp = ihdr[1] == 6 ? 4 : 3;
+
+    // Gather the IDAT data, moving the payloads down over the chunk headers so they are contiguous
+    uint8_t* zdata = nullptr;
+    size_t zsize = 0;
+    size_t pos = 8;
+    bool sawEnd = false;
+    while (!sawEnd) {
+        if (pos + 12 > fileSize) {
+            return DirectDecode::kError;
+        }
+        const size_t length = read32(file + pos);
+        const uint8_t* type = file + pos + 4;
+        if (length > fileSize - pos - 12) {
+            return DirectDecode::kError;
+        }
+        const uint8_t* data = type + 4;
+        const bool critical = !(type[0] & 32);
+        if (critical && read32(data + length) != lodepng_crc32(type, length + 4)) {
+            return DirectDecode::kError;
+        }
+        if (!memcmp(type, "IDAT", 4)) {
+            if (!zdata) {
+                zdata = file + pos + 8;
+            }
+            memmove(zdata + zsize, data, length);
+            zsize += length;
+        } else if (!memcmp(type, "IEND", 4)) {
+            sawEnd = true;
+        } else if (!memcmp(type, "tRNS", 4) || (critical && memcmp(type, "IHDR", 4) && memcmp(type, "PLTE", 4))) {
+            return DirectDecode::kUnsupported;  // color-keyed transparency, or a chunk we don't know
+        }
+        pos += length + 12;
+    }
+
+    // zlib header (deflate, window <= 32K, no dictionary), then the stream, then its Adler-32
+    if (zsize < 6 || (zdata[0] * 256 + zdata[1]) % 31 || (zdata[0] & 15) != 8 || (zdata[0] >> 4) > 7 ||
+        (zdata[1] & 32)) {
+        return DirectDecode::kError;
+    }
+    const size_t srcRowBytes = (size_t) w * bpp + 1;
+    const size_t dstRowBytes = (size_t) w * 4;
+    const size_t filteredSize = srcRowBytes * h;
+    // lodepng_inflate writes from the start of the buffer it is given, and only grows it if the
+    // data doesn't fit: allocating the final size up front means it never reallocates.
+    size_t bufferSize = std::max(filteredSize, dstRowBytes * h);
+    unsigned char* buffer = (unsigned char*) malloc(bufferSize);
+    if (!buffer) {
+        return DirectDecode::kError;
+    }
+    unsigned error = lodepng_inflate(&buffer, &bufferSize, zdata + 2, zsize - 2,
+                                     &lodepng_default_decompress_settings);
+    const unsigned expectedAdler = read32(zdata + zsize - 4);
+    fileOwner.reset();
+    if (error || bufferSize != filteredSize) {
+        free(buffer);
+        return DirectDecode::kError;
+    }
+
+    std::vector<uint8_t> prevRow(w * bpp, 0), currRow(w * bpp);
+    unsigned adler = 1;
+    bool opaque = true;
+    for (unsigned y = 0; y < h; ++y) {
+        const uint8_t* src = buffer + y * srcRowBytes;
+        adler = lodepng_adler32_update(adler, src, srcRowBytes);
+        if (src[0] > 4) {
+            free(buffer);
+            return DirectDecode::kError;
+        }
+        unfilter_row(currRow.data(), src + 1, prevRow.data(), src[0], w * bpp, bpp);
+
+        if (bpp == 4) {
+            // dst row y ends at or before where src row y + 1 starts
+            opaque &= GConvertRGBAToPremul(currRow.data(), w, (GPixel*) (buffer + y * dstRowBytes));
+        } else {
+            // RGB rows are narrower than the pixel rows; stage them at the start of their slot and
+            // widen everything bottom-up once all rows are unfiltered (prev rows would be clobbered).
+            memcpy(buffer + y * (srcRowBytes - 1), currRow.data(), w * 3);
+        }
+        prevRow.swap(currRow);
+    }
+    if (adler != expectedAdler) {
+        free(buffer);
+        return DirectDecode::kError;
+    }
+    if (bpp == 3) {
+        for (unsigned y = h; y-- > 0;) {
+            const uint8_t* rgb = buffer + y * (srcRowBytes - 1);
+            GPixel* dst = (GPixel*) (buffer + y * dstRowBytes);
+            for (unsigned x = w; x-- > 0;) {
+                dst[x] = GPixel_PackARGB(0xFF, rgb[3 * x], rgb[3 * x + 1], rgb[3 * x + 2]);
+            }
+        }
+    }
+
+    // Give back the filter bytes (realloc shrinks in place)
+    if (filteredSize > dstRowBytes * h) {
+        if (void* shrunk = realloc(buffer, dstRowBytes * h)) {
+            buffer = (unsigned char*) shrunk;
+        }
     }
+    bm->reset(w, h, dstRowBytes, (GPixel*) buffer, opaque ? GBitmap::kYes_IsOpaque : GBitmap::kNo_IsOpaque);
+    return DirectDecode::kOK;
 }
 
 bool GBitmap::readFromFile(const char path[]) {
+    switch (GImageFormatForPath(path)) {
+        case GImageFormat::kQOI: return GReadQOI(this, path);
+        case GImageFormat::kPAM: return GReadPAM(this, path);
+        case GImageFormat::kPNG: break;
+    }
+
+    switch (read_png_direct(path, this)) {
+        case DirectDecode::kOK:          return true;
+        case DirectDecode::kError:       return false;
+        case DirectDecode::kUnsupported: break;
+    }
+
     unsigned w, h;
     unsigned char* pix = nullptr;
     if (lodepng_decode32_file(&pix, &w, &h, path)) {
@@ -76,15 +483,14 @@ bool GBitmap::readFromFile(const char path[]) {
     GPixel* dst = this->pixels();
     const uint8_t* src = pix;
     size_t rb = w * 4;
+    bool opaque = true;
     for (unsigned y = 0; y < h; ++y) {
-        swizzle_rgba_row(dst, src, w);
+        opaque &= GConvertRGBAToPremul(src, w, dst);
         src += rb;
         dst += this->rowBytes() / 4;
     }
     free(pix);
 
-    this->setIsOpaque(kCompute_IsOpaque);
+    this->setIsOpaque(opaque ? kYes_IsOpaque : kNo_IsOpaque);
     return true;
 }
-
-
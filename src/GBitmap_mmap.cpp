@@ -0,0 +1,85 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "../include/GBitmap.h"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+bool GBitmap::allocMapped(int w, int h, const char path[]) {
+    this->reset();
+    if (w <= 0 || h <= 0) {
+        return false;
+    }
+    const size_t rb = (size_t) w * sizeof(GPixel);
+    const size_t size = rb * h;
+
+    int fd;
+    if (path) {
+        fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    } else {
+        const char* dir = getenv("TMPDIR");
+        std::string name = std::string(dir && *dir ? dir : "/tmp") + "/gbitmap-XXXXXX";
+        fd = mkstemp(&name[0]);
+        if (fd >= 0) {
+            unlink(name.c_str());  // the mapping keeps it alive until releaseMapped()
+        }
+    }
+    if (fd < 0) {
+        return false;
+    }
+
+    // Extending the file leaves it sparse: disk blocks are only allocated as rows are written, and
+    // reads of untouched rows see zeros, just like calloc.
+    void* addr = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+        addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    // Access comes in bands, not a linear sweep, and untouched pages are holes: readahead around
+    // a fault would only fetch zeros or rows we're not about to use.
+    madvise(addr, size, MADV_RANDOM);
+#ifdef MADV_DONTDUMP
+    madvise(addr, size, MADV_DONTDUMP);  // keep a crash from writing the whole image to a core file
+#endif
+
+    this->reset(w, h, rb, (GPixel*) addr, kNo_IsOpaque);
+    fIsMapped = true;
+    return true;
+}
+
+void GBitmap::releaseMapped() {
+    if (fIsMapped && fPixels) {
+        munmap(fPixels, fRowBytes * fHeight);
+    }
+    this->reset();
+}
+
+void GBitmap::adviseRows(int top, int bottom, RowAdvice advice) const {
+    if (!fIsMapped || top >= bottom) {
+        return;
+    }
+    // madvise works on whole pages; widening the range is harmless for these hints
+    const uintptr_t pageMask = (uintptr_t) sysconf(_SC_PAGESIZE) - 1;
+    uintptr_t start = (uintptr_t) this->getAddr(0, top) & ~pageMask;
+    uintptr_t end = ((uintptr_t) this->getAddr(0, bottom - 1) + fRowBytes + pageMask) & ~pageMask;
+    const uintptr_t mapStart = (uintptr_t) fPixels & ~pageMask;
+    start = start < mapStart ? mapStart : start;
+
+    if (advice == kWillNeed_RowAdvice) {
+        madvise((void*) start, end - start, MADV_WILLNEED);
+    } else {
+        // Dirty pages of a shared file mapping survive MADV_DONTNEED (they stay in the page cache
+        // until written back), so this only lowers our footprint.
+        msync((void*) start, end - start, MS_ASYNC);
+        madvise((void*) start, end - start, MADV_DONTNEED);
+    }
+}
@@ -0,0 +1,156 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "../include/GImageCache.h"
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <sys/stat.h>
+
+// Identifies one version of a file: a rewrite changes the modification time or the size
+struct FileStamp {
+    int64_t mtimeNanos;
+    int64_t size;
+
+    bool operator==(const FileStamp& other) const {
+        return mtimeNanos == other.mtimeNanos && size == other.size;
+    }
+};
+
+static bool stamp_file(const char path[], FileStamp* stamp) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+    stamp->mtimeNanos = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    stamp->size = (int64_t) st.st_size;
+    return true;
+}
+
+// Decodes path into heap pixels that belong to the returned bitmap alone, so later writes to the
+// file never show through
+static std::shared_ptr<const GBitmap> decode(const char path[]) {
+    GBitmap bm;
+    if (!bm.readFromFile(path)) {
+        return nullptr;
+    }
+    return std::shared_ptr<const GBitmap>(new GBitmap(bm), [](const GBitmap* bm) {
+        free(bm->pixels());
+        delete bm;
+    });
+}
+
+static size_t byte_size(const GBitmap& bm) {
+    return bm.rowBytes() * bm.height();
+}
+
+class ImageCache {
+public:
+    std::shared_ptr<const GBitmap> get(const char path[]) {
+        FileStamp stamp;
+        if (!stamp_file(path, &stamp)) {
+            return nullptr;
+        }
+        const std::string key(path);
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            auto found = fEntries.find(key);
+            if (found != fEntries.end()) {
+                if (found->second.fStamp == stamp) {
+                    fLRU.splice(fLRU.begin(), fLRU, found->second.fLRUPos);
+                    return found->second.fBitmap;
+                }
+                this->erase(found);
+            }
+        }
+
+        // Decode without the lock so other files stay available meanwhile. A racing decode of
+        // the same file just loses: whichever finishes first is kept.
+        auto bitmap = decode(path);
+        if (!bitmap) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(fMutex);
+        auto found = fEntries.find(key);
+        if (found != fEntries.end()) {
+            if (found->second.fStamp == stamp) {
+                return found->second.fBitmap;
+            }
+            this->erase(found);
+        }
+        const size_t bytes = byte_size(*bitmap);
+        if (bytes <= fBudget) {
+            fLRU.push_front(key);
+            fEntries[key] = {stamp, bitmap, fLRU.begin()};
+            fBytesUsed += bytes;
+            this->purgeTo(fBudget);
+        }
+        return bitmap;
+    }
+
+    void setBudget(size_t bytes) {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fBudget = bytes;
+        this->purgeTo(fBudget);
+    }
+
+    size_t bytesUsed() {
+        std::lock_guard<std::mutex> lock(fMutex);
+        return fBytesUsed;
+    }
+
+    void purge() {
+        std::lock_guard<std::mutex> lock(fMutex);
+        this->purgeTo(0);
+    }
+
+private:
+    struct Entry {
+        FileStamp                        fStamp;
+        std::shared_ptr<const GBitmap>   fBitmap;
+        std::list<std::string>::iterator fLRUPos;
+    };
+
+    std::mutex                             fMutex;
+    std::unordered_map<std::string, Entry> fEntries;
+    std::list<std::string>                 fLRU;  // most recently used first
+    size_t                                 fBudget = 64 << 20;
+    size_t                                 fBytesUsed = 0;
+
+    void erase(std::unordered_map<std::string, Entry>::iterator entry) {
+        fBytesUsed -= byte_size(*entry->second.fBitmap);
+        fLRU.erase(entry->second.fLRUPos);
+        fEntries.erase(entry);
+    }
+
+    void purgeTo(size_t budget) {
+        while (fBytesUsed > budget) {
+            this->erase(fEntries.find(fLRU.back()));
+        }
+    }
+};
+
+// Never destroyed, so bitmaps may outlive static destruction at exit
+static ImageCache& cache() {
+    static ImageCache* gCache = new ImageCache;
+    return *gCache;
+}
+
+std::shared_ptr<const GBitmap> GImageCacheGet(const char path[]) {
+    return cache().get(path);
+}
+
+void GImageCacheSetBudget(size_t bytes) {
+    cache().setBudget(bytes);
+}
+
+size_t GImageCacheBytesUsed() {
+    return cache().bytesUsed();
+}
+
+void GImageCachePurge() {
+    cache().purge();
+}
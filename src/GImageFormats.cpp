@@ -0,0 +1,496 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "GImageFormats.h"
+#include "../include/GPixelConvert.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+GImageFormat GImageFormatForPath(const char path[]) {
+    const char* dot = strrchr(path, '.');
+    if (dot && !strcasecmp(dot, ".qoi")) {
+        return GImageFormat::kQOI;
+    }
+    if (dot && !strcasecmp(dot, ".pam")) {
+        return GImageFormat::kPAM;
+    }
+    return GImageFormat::kPNG;
+}
+
+// Buffers output so that the encoders can emit a few bytes at a time
+class FileSink {
+public:
+    explicit FileSink(const char path[]) : fFile(fopen(path, "wb")), fOK(fFile != nullptr) {
+        fBuffer.reserve(kBufferBytes + 64);
+    }
+    ~FileSink() { this->close(); }
+
+    uint8_t* reserve(size_t n) {
+        if (fBuffer.size() + n > kBufferBytes) {
+            this->flush();
+        }
+        size_t at = fBuffer.size();
+        fBuffer.resize(at + n);
+        return fBuffer.data() + at;
+    }
+    void trim(uint8_t* end) { fBuffer.resize(end - fBuffer.data()); }
+    void write(const void* data, size_t n) {
+        this->flush();
+        fOK = fOK && fwrite(data, 1, n, fFile) == n;
+    }
+
+    // Returns true only if every write succeeded
+    bool close() {
+        if (fFile) {
+            this->flush();
+            fOK = (fclose(fFile) == 0) && fOK;
+            fFile = nullptr;
+        }
+        return fOK;
+    }
+
+    bool ok() const { return fOK; }
+
+private:
+    enum { kBufferBytes = 1 << 16 };
+
+    void flush() {
+        if (fOK && !fBuffer.empty()) {
+            fOK = fwrite(fBuffer.data(), 1, fBuffer.size(), fFile) == fBuffer.size();
+        }
+        fBuffer.clear();
+    }
+
+    FILE*                fFile;
+    bool                 fOK;
+    std::vector<uint8_t> fBuffer;
+};
+
+// A read-only view of a whole file
+class FileMap {
+public:
+    explicit FileMap(const char path[]) {
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if (fd < 0) {
+            return;
+        }
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                fData = (const uint8_t*) addr;
+                fSize = st.st_size;
+                madvise(addr, fSize, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+    }
+    ~FileMap() {
+        if (fData) {
+            munmap((void*) fData, fSize);
+        }
+    }
+
+    const uint8_t* data() const { return fData; }
+    size_t size() const { return fSize; }
+
+private:
+    const uint8_t* fData = nullptr;
+    size_t         fSize = 0;
+};
+
+static void put32(uint8_t* p, unsigned x) {
+    p[0] = x >> 24;
+    p[1] = x >> 16;
+    p[2] = x >> 8;
+    p[3] = x;
+}
+
+static unsigned read32(const uint8_t p[]) {
+    return ((unsigned) p[0] << 24) | ((unsigned) p[1] << 16) | ((unsigned) p[2] << 8) | p[3];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// QOI
+
+enum {
+    kQOI_Index = 0x00,  // 00xxxxxx
+    kQOI_Diff  = 0x40,  // 01xxxxxx
+    kQOI_Luma  = 0x80,  // 10xxxxxx
+    kQOI_Run   = 0xC0,  // 11xxxxxx
+    kQOI_RGB   = 0xFE,
+    kQOI_RGBA  = 0xFF,
+    kQOI_Mask2 = 0xC0,
+};
+
+static const uint8_t kQOIPadding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+struct QOIPixel {
+    uint8_t r, g, b, a;
+};
+
+static inline bool operator==(QOIPixel x, QOIPixel y) {
+    return x.r == y.r && x.g == y.g && x.b == y.b && x.a == y.a;
+}
+
+static inline int qoi_hash(QOIPixel p) {
+    return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) & 63;
+}
+
+bool GWriteQOI(const GBitmap& bm, const char path[]) {
+    const int w = bm.width(), h = bm.height();
+    if (w <= 0 || h <= 0) {
+        return false;
+    }
+    FileSink sink(path);
+    uint8_t* header = sink.reserve(14);
+    memcpy(header, "qoif", 4);
+    put32(header + 4, w);
+    put32(header + 8, h);
+    header[12] = 4;  // RGBA
+    header[13] = 0;  // sRGB with linear alpha
+
+    QOIPixel index[64] = {};
+    QOIPixel prev = {0, 0, 0, 255};
+    int run = 0;
+    std::vector<QOIPixel> row(w);
+    for (int y = 0; y < h; ++y) {
+        GConvertPremulToRGBA(bm.getAddr(0, y), w, (uint8_t*) row.data());
+        uint8_t* out = sink.reserve(5 * w + 1);  // worst case: every pixel is an RGBA op
+        for (int x = 0; x < w; ++x) {
+            const QOIPixel px = row[x];
+            if (px == prev) {
+                if (++run == 62) {
+                    *out++ = kQOI_Run | (run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *out++ = kQOI_Run | (run - 1);
+                run = 0;
+            }
+
+            const int slot = qoi_hash(px);
+            if (index[slot] == px) {
+                *out++ = kQOI_Index | slot;
+            } else {
+                index[slot] = px;
+                if (px.a == prev.a) {
+                    const int8_t dr = px.r - prev.r;
+                    const int8_t dg = px.g - prev.g;
+                    const int8_t db = px.b - prev.b;
+                    const int8_t dr_dg = dr - dg;
+                    const int8_t db_dg = db - dg;
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        *out++ = kQOI_Diff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+                    } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                        *out++ = kQOI_Luma | (dg + 32);
+                        *out++ = (dr_dg + 8) << 4 | (db_dg + 8);
+                    } else {
+                        *out++ = kQOI_RGB;
+                        *out++ = px.r;
+                        *out++ = px.g;
+                        *out++ = px.b;
+                    }
+                } else {
+                    *out++ = kQOI_RGBA;
+                    *out++ = px.r;
+                    *out++ = px.g;
+                    *out++ = px.b;
+                    *out++ = px.a;
+                }
+            }
+            prev = px;
+        }
+        if (y == h - 1 && run > 0) {
+            *out++ = kQOI_Run | (run - 1);
+        }
+        sink.trim(out);
+    }
+    memcpy(sink.reserve(8), kQOIPadding, 8);
+    return sink.close();
+}
+
+// Decodes the ops in [p, end) into dst; returns false if they run out before the last pixel
+static bool qoi_decode(const uint8_t* p, const uint8_t* end, GBitmap* dst, bool* opaque) {
+    const int w = dst->width();
+    QOIPixel index[64] = {};
+    QOIPixel px = {0, 0, 0, 255};
+    int run = 0;
+    std::vector<QOIPixel> row(w);
+    *opaque = true;
+    for (int y = 0; y < dst->height(); ++y) {
+        for (int x = 0; x < w; ++x) {
+            if (run > 0) {
+                --run;
+                row[x] = px;
+                continue;
+            }
+            if (p == end) {
+                return false;
+            }
+            const uint8_t op = *p++;
+            if (op == kQOI_RGB) {
+                if (end - p < 3) return false;
+                px.r = p[0];
+                px.g = p[1];
+                px.b = p[2];
+                p += 3;
+            } else if (op == kQOI_RGBA) {
+                if (end - p < 4) return false;
+                px = {p[0], p[1], p[2], p[3]};
+                p += 4;
+            } else if ((op & kQOI_Mask2) == kQOI_Index) {
+                px = index[op];
+            } else if ((op & kQOI_Mask2) == kQOI_Diff) {
+                px.r += ((op >> 4) & 3) - 2;
+                px.g += ((op >> 2) & 3) - 2;
+                px.b += (op & 3) - 2;
+            } else if ((op & kQOI_Mask2) == kQOI_Luma) {
+                if (p == end) return false;
+                const int dg = (op & 0x3F) - 32;
+                const uint8_t next = *p++;
+                px.r += dg - 8 + (next >> 4);
+                px.g += dg;
+                px.b += dg - 8 + (next & 15);
+            } else {
+                run = op & 0x3F;
+            }
+            index[qoi_hash(px)] = px;
+            row[x] = px;
+        }
+        *opaque &= GConvertRGBAToPremul((const uint8_t*) row.data(), w, dst->getAddr(0, y));
+    }
+    return true;
+}
+
+bool GReadQOI(GBitmap* bm, const char path[]) {
+    FileMap file(path);
+    const uint8_t* p = file.data();
+    if (file.size() < 14 + 8 || memcmp(p, "qoif", 4)) {
+        return false;
+    }
+    const unsigned w = read32(p + 4), h = read32(p + 8);
+    const int channels = p[12];
+    // An op byte decodes to at most 62 pixels (a full run), so the file bounds what it can encode
+    const uint64_t maxPixels = std::min<uint64_t>(INT_MAX / 4, (file.size() - 14 - 8) * (uint64_t) 62);
+    if (w == 0 || h == 0 || (uint64_t) w * h > maxPixels || (channels != 3 && channels != 4)) {
+        return false;
+    }
+
+    GBitmap result;
+    result.alloc(w, h);
+    if (!result.pixels()) {
+        return false;
+    }
+    bool opaque;
+    if (!qoi_decode(p + 14, p + file.size() - 8, &result, &opaque)) {
+        free(result.pixels());
+        return false;
+    }
+    result.setIsOpaque(opaque ? GBitmap::kYes_IsOpaque : GBitmap::kNo_IsOpaque);
+    *bm = result;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PAM
+
+enum {
+    kPAMHeaderBytes = 64,  // keeps the pixels cache-line aligned in the file and in a mapping
+};
+
+static const char kPremulTupleType[] = "GPIXEL_PREMUL";
+static const char kOpaqueTupleType[] = "GPIXEL_PREMUL_OPAQUE";
+
+bool GWritePAM(const GBitmap& bm, const char path[]) {
+    const int w = bm.width(), h = bm.height();
+    if (w <= 0 || h <= 0) {
+        return false;
+    }
+    char header[256];
+    int n = snprintf(header, sizeof(header), "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE %s\n",
+                     w, h, bm.isOpaque() ? kOpaqueTupleType : kPremulTupleType);
+    // Pad with a comment line so that the header ends exactly on a 64-byte boundary
+    const int suffix = (int) sizeof("#\nENDHDR\n") - 1;
+    const int padded = (n + suffix + kPAMHeaderBytes - 1) / kPAMHeaderBytes * kPAMHeaderBytes;
+    n += snprintf(header + n, sizeof(header) - n, "#%*s\nENDHDR\n", padded - n - suffix, "");
+
+    FileSink sink(path);
+    sink.write(header, n);
+    if (bm.rowBytes() == (size_t) w * 4) {
+        sink.write(bm.pixels(), (size_t) w * h * 4);
+    } else {
+        for (int y = 0; y < h; ++y) {
+            sink.write(bm.getAddr(0, y), (size_t) w * 4);
+        }
+    }
+    return sink.close();
+}
+
+// Parses the PAM header; returns the offset of the pixel data, or 0 if it isn't one we can read
+static size_t parse_pam_header(const uint8_t data[], size_t size, int* w, int* h, int* depth,
+                               std::string* tupleType) {
+    if (size < 3 || memcmp(data, "P7\n", 3)) {
+        return 0;
+    }
+    int maxval = 0;
+    size_t pos = 3;
+    *w = *h = *depth = 0;
+    while (pos < size) {
+        const uint8_t* eol = (const uint8_t*) memchr(data + pos, '\n', size - pos);
+        if (!eol) {
+            return 0;
+        }
+        std::string line((const char*) data + pos, eol - (data + pos));
+        pos = eol - data + 1;
+        if (line == "ENDHDR") {
+            return (*w > 0 && *h > 0 && maxval == 255) ? pos : 0;
+        }
+        char key[16], value[64];
+        if (line.empty() || line[0] == '#' || sscanf(line.c_str(), "%15s %63s", key, value) != 2) {
+            continue;
+        }
+        if (!strcmp(key, "WIDTH")) {
+            *w = atoi(value);
+        } else if (!strcmp(key, "HEIGHT")) {
+            *h = atoi(value);
+        } else if (!strcmp(key, "DEPTH")) {
+            *depth = atoi(value);
+        } else if (!strcmp(key, "MAXVAL")) {
+            maxval = atoi(value);
+        } else if (!strcmp(key, "TUPLTYPE")) {
+            *tupleType = value;
+        }
+    }
+    return 0;
+}
+
+// Reads whole of [offset, offset + n) from fd, retrying short reads
+static bool read_fully(int fd, void* dst, size_t n, size_t offset) {
+    uint8_t* p = (uint8_t*) dst;
+    while (n > 0) {
+        const ssize_t got = pread(fd, p, n, offset);
+        if (got <= 0) {
+            return false;
+        }
+        p += got;
+        n -= got;
+        offset += got;
+    }
+    return true;
+}
+
+// Header fields of an open .pam file we know how to read
+struct PAMInfo {
+    int    w, h;
+    size_t offset;  // of the pixel data
+    size_t size;    // of the whole file
+    bool   premul, opaque;
+};
+
+static bool read_pam_info(int fd, PAMInfo* info) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        return false;
+    }
+    uint8_t header[4096];
+    const size_t headerBytes = std::min((size_t) st.st_size, sizeof(header));
+    if (!read_fully(fd, header, headerBytes, 0)) {
+        return false;
+    }
+    int depth;
+    std::string tupleType;
+    info->offset = parse_pam_header(header, headerBytes, &info->w, &info->h, &depth, &tupleType);
+    info->size = st.st_size;
+    info->premul = tupleType == kPremulTupleType || tupleType == kOpaqueTupleType;
+    info->opaque = tupleType == kOpaqueTupleType;
+    return info->offset && depth == 4 && (info->premul || tupleType == "RGB_ALPHA") &&
+           info->size - info->offset >= (size_t) info->w * info->h * 4;
+}
+
+bool GReadPAM(GBitmap* bm, const char path[]) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    PAMInfo info;
+    if (!read_pam_info(fd, &info)) {
+        close(fd);
+        return false;
+    }
+    const int w = info.w, h = info.h;
+    const size_t rowBytes = (size_t) w * 4;
+
+    GBitmap result;
+    result.alloc(w, h, GBitmap::kUninitialized_AllocFlag);
+    if (!result.pixels()) {
+        close(fd);
+        return false;
+    }
+    bool ok, opaque = true;
+    if (info.premul) {
+        // Our own dumps are already in memory layout: read straight into the pixels
+        ok = read_fully(fd, result.pixels(), rowBytes * h, info.offset);
+    } else {
+        // Convert a band of rows at a time so the staging buffer stays cache sized
+        const int bandRows = std::max(1, (int) ((1 << 16) / rowBytes));
+        std::vector<uint8_t> band(rowBytes * bandRows);
+        ok = true;
+        for (int y = 0; ok && y < h; y += bandRows) {
+            const int rows = std::min(bandRows, h - y);
+            ok = read_fully(fd, band.data(), rowBytes * rows, info.offset + rowBytes * y);
+            for (int i = 0; ok && i < rows; ++i) {
+                opaque &= GConvertRGBAToPremul(band.data() + rowBytes * i, w, result.getAddr(0, y + i));
+            }
+        }
+    }
+    close(fd);
+    if (!ok) {
+        free(result.pixels());
+        return false;
+    }
+    opaque = info.premul ? info.opaque : opaque;
+    result.setIsOpaque(opaque ? GBitmap::kYes_IsOpaque : GBitmap::kNo_IsOpaque);
+    *bm = result;
+    return true;
+}
+
+std::shared_ptr<const GBitmap> GMapPAM(const char path[]) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    PAMInfo info;
+    void* addr = MAP_FAILED;
+    if (read_pam_info(fd, &info) && info.premul && info.offset % 4 == 0) {
+        addr = mmap(nullptr, info.size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return nullptr;
+    }
+    madvise(addr, info.size, MADV_WILLNEED);
+
+    GBitmap* bm = new GBitmap;
+    bm->reset(info.w, info.h, (size_t) info.w * 4, (GPixel*) ((uint8_t*) addr + info.offset),
+              info.opaque ? GBitmap::kYes_IsOpaque : GBitmap::kNo_IsOpaque);
+    const size_t size = info.size;
+    return std::shared_ptr<const GBitmap>(bm, [addr, size](const GBitmap* bm) {
+        munmap(addr, size);
+        delete bm;
+    });
+}
@@ -0,0 +1,45 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#ifndef GImageFormats_DEFINED
+#define GImageFormats_DEFINED
+
+#include "../include/GBitmap.h"
+
+#include <memory>
+
+/*
+ *  Formats for intermediate images, picked by GBitmap::readFromFile/writeToFile from the file
+ *  extension (anything else is PNG):
+ *
+ *  .qoi   QOI (qoiformat.org): lossless and unpremultiplied like PNG, but encodes and decodes in a
+ *         single cheap pass, with no entropy coding.
+ *  .pam   Netpbm PAM header (padded to 64 bytes) followed by the pixels exactly as they are in
+ *         memory (TUPLTYPE GPIXEL_PREMUL, native byte order), so reading is a single read() into
+ *         the malloc'd pixels, with no conversion. Standard RGB_ALPHA PAMs are also read.
+ */
+enum class GImageFormat {
+    kPNG,
+    kQOI,
+    kPAM,
+};
+
+GImageFormat GImageFormatForPath(const char path[]);
+
+bool GWriteQOI(const GBitmap&, const char path[]);
+bool GReadQOI(GBitmap*, const char path[]);
+
+bool GWritePAM(const GBitmap&, const char path[]);
+bool GReadPAM(GBitmap*, const char path[]);
+
+/*
+ *  Zero-copy alternative to GReadPAM for our own premultiplied dumps: the returned bitmap's pixels
+ *  are a read-only mapping of the file, unmapped when the last reference goes. The mapping is
+ *  live, so while it is held the file must not be rewritten in place (the pixels would change
+ *  underneath) or truncated (reading the lost pages raises SIGBUS); replacing it by rename is safe.
+ *  Returns null if the file can't be mapped this way.
+ */
+std::shared_ptr<const GBitmap> GMapPAM(const char path[]);
+
+#endif
@@ -5,6 +5,8 @@
 #include "../include/GPathBuilder.h"
 #include "../include/GMatrix.h"
 
+#include <algorithm>
+
 void GPathBuilder::reset() {
     fPts.clear();
     fVbs.clear();
@@ -41,31 +43,111 @@ void GPathBuilder::transform(const GMatrix& m) {
 }
 
 std::shared_ptr<GPath> GPathBuilder::detach() {
-    auto path = std::make_shared<GPath>(std::move(fPts), std::move(fVbs));
+    // Copy into the path's compact storage; reset() keeps our capacity for the next path.
+    auto path = GPath::Make(fPts.data(), (int) fPts.size(), fVbs.data(), (int) fVbs.size());
     this->reset();
     return path;
 }
 
 /////////////////////////////////////////////////////////////
 
+// Allocates the shared_ptr control block that holds a GPath, plus fExtra trailing bytes for its
+// points and verbs (reported through fTail), so each path is one allocation. A path over external
+// storage keeps that storage's owner here, in the control block, rather than in the GPath.
+template <typename T> struct PathAllocator {
+    using value_type = T;
+
+    PathAllocator(size_t extra, unsigned char** tail, std::shared_ptr<const void> owner)
+        : fExtra(extra), fTail(tail), fOwner(std::move(owner)) {}
+    template <typename U> PathAllocator(const PathAllocator<U>& other)
+        : fExtra(other.fExtra), fTail(other.fTail), fOwner(other.fOwner) {}
+
+    T* allocate(size_t n) {
+        const size_t bytes = n * sizeof(T);  // a multiple of alignof(T), which suits the points
+        unsigned char* block = static_cast<unsigned char*>(::operator new(bytes + fExtra));
+        if (fTail) {
+            *fTail = block + bytes;
+        }
+        return reinterpret_cast<T*>(block);
+    }
+    void deallocate(T* p, size_t) { ::operator delete(p); }
+
+    template <typename U> bool operator==(const PathAllocator<U>& other) const {
+        return fExtra == other.fExtra && fOwner == other.fOwner;
+    }
+    template <typename U> bool operator!=(const PathAllocator<U>& other) const { return !(*this == other); }
+
+    size_t                      fExtra;
+    unsigned char**             fTail;
+    std::shared_ptr<const void> fOwner;
+};
+
+static_assert(alignof(GPath) >= alignof(GPoint), "trailing points must be aligned");
+
+std::shared_ptr<GPath> GPath::Alloc(int ptCount, int vbCount, GPoint** pts, GPathVerb** vbs) {
+    const size_t ptBytes = ptCount * sizeof(GPoint);
+    unsigned char* storage = nullptr;
+    auto path = std::allocate_shared<GPath>(
+            PathAllocator<GPath>(ptBytes + vbCount * sizeof(GPathVerb), &storage, nullptr), Key());
+    *pts = reinterpret_cast<GPoint*>(storage);
+    *vbs = reinterpret_cast<GPathVerb*>(storage + ptBytes);
+    path->fPts = *pts;
+    path->fVbs = *vbs;
+    path->fPtCount = ptCount;
+    path->fVbCount = vbCount;
+    return path;
+}
+
+std::shared_ptr<GPath> GPath::Make(const GPoint pts[], int ptCount, const GPathVerb vbs[], int vbCount) {
+    GPoint* dstPts;
+    GPathVerb* dstVbs;
+    auto path = Alloc(ptCount, vbCount, &dstPts, &dstVbs);
+    std::copy(pts, pts + ptCount, dstPts);
+    std::copy(vbs, vbs + vbCount, dstVbs);
+    path->fBounds = path->computeBounds();
+    return path;
+}
+
+std::shared_ptr<GPath> GPath::MakeExternal(const GPoint pts[], int ptCount, const GPathVerb vbs[],
+                                           int vbCount, const GRect& bounds,
+                                           std::shared_ptr<const void> owner) {
+    auto path = std::allocate_shared<GPath>(PathAllocator<GPath>(0, nullptr, std::move(owner)), Key());
+    path->fPts = pts;
+    path->fVbs = vbs;
+    path->fPtCount = ptCount;
+    path->fVbCount = vbCount;
+    path->fBounds = bounds;
+    return path;
+}
+
+GPath::~GPath() {
+    DropSegmentIndex(this);
+}
+
+/////////////////////////////////////////////////////////////
+
 static bool is_identity(const GMatrix& m) {
     return m[0] == 1 && m[3] == 1 &&
            m[1] == 0 && m[2] == 0 && m[4] == 0 && m[5] == 0;
 }
 
 std::shared_ptr<GPath> GPath::transform(const GMatrix& m) const {
-    if (fPts.empty() || is_identity(m)) {
+    if (fPtCount == 0 || is_identity(m)) {
         return const_cast<GPath*>(this)->shared_from_this();
     }
-    std::vector<GPoint> dst(fPts.size());
-    m.mapPoints(dst.data(), fPts.data(), fPts.size());
-    return std::make_shared<GPath>(std::move(dst), fVbs);
+    GPoint* pts;
+    GPathVerb* vbs;
+    auto path = Alloc(fPtCount, fVbCount, &pts, &vbs);
+    m.mapPoints(pts, fPts, fPtCount);
+    std::copy(fVbs, fVbs + fVbCount, vbs);
+    path->fBounds = path->computeBounds();
+    return path;
 }
 
 GPath::Iter::Iter(const GPath& path) {
-    fCurrPt = path.fPts.data();
-    fCurrVb = path.fVbs.data();
-    fStopVb = fCurrVb + path.fVbs.size();
+    fCurrPt = path.fPts;
+    fCurrVb = path.fVbs;
+    fStopVb = fCurrVb + path.fVbCount;
 }
 
 std::optional<GPathVerb> GPath::Iter::next(GPoint pts[]) {
@@ -101,19 +183,33 @@ constexpr int kDoneVerb = -1;
 
 GPath::Edger::Edger(const GPath& path) {
     fPrevMove = nullptr;
-    fCurrPt = path.fPts.data();
-    fCurrVb = path.fVbs.data();
-    fStopVb = fCurrVb + path.fVbs.size();
+    fCurrPt = path.fPts;
+    fCurrVb = path.fVbs;
+    fStopVb = fCurrVb + path.fVbCount;
     fPrevVerb = kDoneVerb;
+    fMapPoints = false;
+}
+
+GPath::Edger::Edger(const GPath& path, const GMatrix& m) : Edger(path) {
+    fMatrix = m;
+    fMapPoints = !is_identity(m);
 }
 
 std::optional<GPathVerb> GPath::Edger::next(GPoint pts[]) {
+    auto v = this->nextLocal(pts);
+    if (v && fMapPoints) {
+        fMatrix.mapPoints(pts, v.value() + 1);  // kLine, kQuad, kCubic return 2, 3, 4 points
+    }
+    return v;
+}
+
+std::optional<GPathVerb> GPath::Edger::nextLocal(GPoint pts[]) {
     assert(fCurrVb <= fStopVb);
     bool do_return = false;
     while (fCurrVb < fStopVb) {
         switch (*fCurrVb++) {
             case kMove:
-                if (fPrevVerb == kLine) {
+                if (fPrevVerb >= kLine && fPrevVerb <= kCubic) {
                     pts[0] = fCurrPt[-1];
                     pts[1] = *fPrevMove;
                     do_return = true;
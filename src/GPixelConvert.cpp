@@ -0,0 +1,100 @@
+/*
+ *  Copyright 2024 Christine Hu
+ */
+
+#include "../include/GPixelConvert.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void GConvertPremulToRGBA(const GPixel src[], int count, uint8_t dst[]) {
+    int i = 0;
+#if defined(__SSE2__)
+    /* 4 pixels per iteration in float, one channel per register. n / a is a multiple of 1/a, so
+     * the float rounding error (well under 1/1024) plus a 1/1024 nudge never changes the floor.
+     */
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 v255 = _mm_set1_ps(255.f);
+    const __m128 nudge = _mm_set1_ps(1.f / 1024);
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i a = _mm_srli_epi32(pixels, GPIXEL_SHIFT_A);
+        __m128i halfA = _mm_srli_epi32(a, 1);
+        __m128i r = _mm_and_si128(_mm_srli_epi32(pixels, GPIXEL_SHIFT_R), byteMask);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, GPIXEL_SHIFT_G), byteMask);
+        __m128i b = _mm_and_si128(_mm_srli_epi32(pixels, GPIXEL_SHIFT_B), byteMask);
+
+        __m128 fa = _mm_cvtepi32_ps(a);
+        __m128 fHalf = _mm_cvtepi32_ps(halfA);
+        __m128 invA = _mm_and_ps(_mm_cmpgt_ps(fa, _mm_setzero_ps()), _mm_div_ps(one, _mm_max_ps(fa, one)));
+        __m128 fr = _mm_min_ps(_mm_cvtepi32_ps(r), fa);
+        __m128 fg = _mm_min_ps(_mm_cvtepi32_ps(g), fa);
+        __m128 fb = _mm_min_ps(_mm_cvtepi32_ps(b), fa);
+        fr = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(fr, v255), fHalf), invA), nudge);
+        fg = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(fg, v255), fHalf), invA), nudge);
+        fb = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(fb, v255), fHalf), invA), nudge);
+
+        // a == 0 gives 0 + nudge, which truncates to 0
+        __m128i out = _mm_or_si128(_mm_or_si128(_mm_cvttps_epi32(fr), _mm_slli_epi32(_mm_cvttps_epi32(fg), 8)),
+                                   _mm_or_si128(_mm_slli_epi32(_mm_cvttps_epi32(fb), 16), _mm_slli_epi32(a, 24)));
+        _mm_storeu_si128((__m128i*) (dst + 4 * i), out);
+    }
+#endif
+    for (; i < count; ++i) {
+        GPixel c = src[i];
+        unsigned a = GPixel_GetA(c);
+        dst[4 * i + 0] = GUnpremulComponent(GPixel_GetR(c), a);
+        dst[4 * i + 1] = GUnpremulComponent(GPixel_GetG(c), a);
+        dst[4 * i + 2] = GUnpremulComponent(GPixel_GetB(c), a);
+        dst[4 * i + 3] = a;
+    }
+}
+
+// Returns (x + 127) / 255 for 0 <= x <= 255 * 255
+static inline unsigned div255(unsigned x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+bool GConvertRGBAToPremul(const uint8_t src[], int count, GPixel dst[]) {
+    unsigned alphaAnd = 0xFF;
+    int i = 0;
+#if defined(__SSE2__)
+    // 4 pixels per iteration, one channel per 32-bit lane; every product fits in 16 bits.
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i bias = _mm_set1_epi32(128);
+    __m128i alphas = _mm_set1_epi32(0xFF);
+    for (; i + 4 <= count; i += 4) {
+        __m128i rgba = _mm_loadu_si128((const __m128i*) (src + 4 * i));
+        __m128i a = _mm_srli_epi32(rgba, 24);
+        alphas = _mm_and_si128(alphas, a);
+        __m128i r = _mm_mullo_epi16(_mm_and_si128(rgba, byteMask), a);
+        __m128i g = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(rgba, 8), byteMask), a);
+        __m128i b = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(rgba, 16), byteMask), a);
+        r = _mm_add_epi32(r, bias);
+        g = _mm_add_epi32(g, bias);
+        b = _mm_add_epi32(b, bias);
+        r = _mm_srli_epi32(_mm_add_epi32(r, _mm_srli_epi32(r, 8)), 8);
+        g = _mm_srli_epi32(_mm_add_epi32(g, _mm_srli_epi32(g, 8)), 8);
+        b = _mm_srli_epi32(_mm_add_epi32(b, _mm_srli_epi32(b, 8)), 8);
+
+        __m128i out = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(a, GPIXEL_SHIFT_A), _mm_slli_epi32(r, GPIXEL_SHIFT_R)),
+                                   _mm_or_si128(_mm_slli_epi32(g, GPIXEL_SHIFT_G), _mm_slli_epi32(b, GPIXEL_SHIFT_B)));
+        _mm_storeu_si128((__m128i*) (dst + i), out);
+    }
+    alignas(16) uint32_t lanes[4];
+    _mm_store_si128((__m128i*) lanes, alphas);
+    alphaAnd = lanes[0] & lanes[1] & lanes[2] & lanes[3];
+#endif
+    for (; i < count; ++i) {
+        unsigned a = src[4 * i + 3];
+        alphaAnd &= a;
+        dst[i] = GPixel_PackARGB(a,
+                                 div255(a * src[4 * i + 0]),
+                                 div255(a * src[4 * i + 1]),
+                                 div255(a * src[4 * i + 2]));
+    }
+    return alphaAnd == 0xFF;
+}
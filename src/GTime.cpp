@@ -4,15 +4,18 @@
 
 #include "../include/GTime.h"
 
-#include <sys/time.h>
+#include <time.h>
 
 GMSec GTime::GetMSec() {
-    struct timeval tv;
+    return (GMSec)(GetNSec() / 1000000);
+}
+
+GNSec GTime::GetNSec() {
+    struct timespec ts;
 
-    if (gettimeofday(&tv, NULL)) {
+    if (clock_gettime(CLOCK_MONOTONIC, &ts)) {
         return 0;
     } else {
-        return tv.tv_sec * 1000 + tv.tv_usec / 1000;
+        return (GNSec)ts.tv_sec * 1000000000 + ts.tv_nsec;
     }
 }
-
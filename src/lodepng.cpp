@@ -34,6 +34,10 @@ Rename this file to lodepng.cpp to use it for C++, or to lodepng.c to use it for
 #include <stdio.h>
 #include <stdlib.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #if defined(_MSC_VER) && (_MSC_VER >= 1310) /*Visual Studio: A few warning types are not desired here.*/
 #pragma warning( disable : 4244 ) /*implicit conversions: not warned by gcc -Wall -Wextra and requires too much casts*/
 #pragma warning( disable : 4996 ) /*VS does not like fopen, but fopen_s is not standard C so unusable here*/
@@ -461,13 +465,19 @@ static unsigned char readBitFromStream(size_t* bitpointer, const unsigned char*
 
 static unsigned readBitsFromStream(size_t* bitpointer, const unsigned char* bitstream, size_t nbits)
 {
-  unsigned result = 0, i;
-  for(i = 0; i != nbits; ++i)
+  /*a byte at a time; only the bytes holding the nbits bits are read, so this stays within the stream*/
+  size_t p = (*bitpointer) >> 3;
+  unsigned got, result;
+  if(nbits == 0) return 0;
+  got = 8 - ((*bitpointer) & 7);
+  result = (unsigned)bitstream[p] >> ((*bitpointer) & 7);
+  while(got < nbits)
   {
-    result += ((unsigned)READBIT(*bitpointer, bitstream)) << i;
-    ++(*bitpointer);
+    result |= (unsigned)bitstream[++p] << got;
+    got += 8;
   }
-  return result;
+  (*bitpointer) += nbits;
+  return result & ((1u << nbits) - 1u);
 }
 #endif /*LODEPNG_COMPILE_DECODER*/
 
@@ -517,6 +527,10 @@ Huffman tree struct, containing multiple representations of the tree
 typedef struct HuffmanTree
 {
   unsigned* tree2d;
+  /*first-level decoding table indexed by the next FIRSTBITS bits of the stream: (value << 4) | length,
+  where length <= FIRSTBITS means value is the symbol, TABLE_CONTINUE means value is the tree2d position
+  after FIRSTBITS bits, and TABLE_INVALID means the bits walk off the tree*/
+  unsigned short* table;
   unsigned* tree1d;
   unsigned* lengths; /*the lengths of the codes of the 1d-tree*/
   unsigned maxbitlen; /*maximum number of bits a single code can get*/
@@ -536,9 +550,14 @@ static void HuffmanTree_draw(HuffmanTree* tree)
   std::cout << std::endl;
 }*/
 
+#define FIRSTBITS 9u
+#define TABLE_CONTINUE 15u
+#define TABLE_INVALID 14u
+
 static void HuffmanTree_init(HuffmanTree* tree)
 {
   tree->tree2d = 0;
+  tree->table = 0;
   tree->tree1d = 0;
   tree->lengths = 0;
 }
@@ -546,6 +565,7 @@ static void HuffmanTree_init(HuffmanTree* tree)
 static void HuffmanTree_cleanup(HuffmanTree* tree)
 {
   lodepng_free(tree->tree2d);
+  lodepng_free(tree->table);
   lodepng_free(tree->tree1d);
   lodepng_free(tree->lengths);
 }
@@ -608,6 +628,28 @@ static unsigned HuffmanTree_make2DTree(HuffmanTree* tree)
     if(tree->tree2d[n] == 32767) tree->tree2d[n] = 0; /*remove possible remaining 32767's*/
   }
 
+  /*walk the tree once for every possible FIRSTBITS-bit prefix (the first bit read is the lowest bit)*/
+  tree->table = (unsigned short*)lodepng_malloc((1u << FIRSTBITS) * sizeof(unsigned short));
+  if(!tree->table) return 83; /*alloc fail*/
+  for(n = 0; n < (1u << FIRSTBITS); ++n)
+  {
+    unsigned entry = (0u << 4) | TABLE_INVALID;
+    treepos = 0;
+    for(i = 0; i < FIRSTBITS; ++i)
+    {
+      unsigned ct = tree->tree2d[(treepos << 1) + ((n >> i) & 1u)];
+      if(ct < tree->numcodes)
+      {
+        entry = (ct << 4) | (i + 1);
+        break;
+      }
+      treepos = ct - tree->numcodes;
+      if(treepos >= tree->numcodes) break; /*invalid*/
+      if(i + 1 == FIRSTBITS) entry = (treepos << 4) | TABLE_CONTINUE;
+    }
+    tree->table[n] = (unsigned short)entry;
+  }
+
   return 0;
 }
 
@@ -956,6 +998,22 @@ static unsigned huffmanDecodeSymbol(const unsigned char* in, size_t* bp,
                                     const HuffmanTree* codetree, size_t inbitlength)
 {
   unsigned treepos = 0, ct;
+  if(*bp + FIRSTBITS <= inbitlength)
+  {
+    /*resolve the first FIRSTBITS bits with one table lookup; the two bytes read are within the input*/
+    size_t p = (*bp) >> 3;
+    unsigned bits = ((unsigned)in[p] | ((unsigned)in[p + 1] << 8)) >> ((*bp) & 7);
+    unsigned entry = codetree->table[bits & ((1u << FIRSTBITS) - 1)];
+    unsigned length = entry & 15;
+    if(length <= FIRSTBITS)
+    {
+      (*bp) += length;
+      return entry >> 4;
+    }
+    if(length == TABLE_INVALID) return (unsigned)(-1);
+    (*bp) += FIRSTBITS;
+    treepos = entry >> 4;
+  }
   for(;;)
   {
     if(*bp >= inbitlength) return (unsigned)(-1); /*error: end of input memory reached without endcode*/
@@ -1658,7 +1716,7 @@ static unsigned encodeLZ77(uivector* out, Hash* hash,
 
 /* /////////////////////////////////////////////////////////////////////////// */
 
-static unsigned deflateNoCompression(ucvector* out, const unsigned char* data, size_t datasize)
+static unsigned deflateNoCompression(ucvector* out, const unsigned char* data, size_t datasize, unsigned last)
 {
   /*non compressed deflate block data: 1 bit BFINAL,2 bits BTYPE,(5 bits): it jumps to start of next byte,
   2 bytes LEN, 2 bytes NLEN, LEN bytes literal DATA*/
@@ -1670,7 +1728,7 @@ static unsigned deflateNoCompression(ucvector* out, const unsigned char* data, s
     unsigned BFINAL, BTYPE, LEN, NLEN;
     unsigned char firstbyte;
 
-    BFINAL = (i == numdeflateblocks - 1);
+    BFINAL = last && (i == numdeflateblocks - 1);
     BTYPE = 0;
 
     firstbyte = (unsigned char)(BFINAL + ((BTYPE & 1) << 1) + ((BTYPE & 2) << 1));
@@ -2022,8 +2080,13 @@ static unsigned deflateFixed(ucvector* out, size_t* bp, Hash* hash,
   return error;
 }
 
+/*
+last: whether this is the end of the deflate stream. If not, no block is marked final and the output is
+ended with an empty stored block (like zlib's Z_SYNC_FLUSH), so it ends on a byte boundary and the next
+chunk's blocks can simply be appended.
+*/
 static unsigned lodepng_deflatev(ucvector* out, const unsigned char* in, size_t insize,
-                                 const LodePNGCompressSettings* settings)
+                                 const LodePNGCompressSettings* settings, unsigned last)
 {
   unsigned error = 0;
   size_t i, blocksize, numdeflateblocks;
@@ -2031,7 +2094,18 @@ static unsigned lodepng_deflatev(ucvector* out, const unsigned char* in, size_t
   Hash hash;
 
   if(settings->btype > 2) return 61;
-  else if(settings->btype == 0) return deflateNoCompression(out, in, insize);
+  else if(settings->btype == 0)
+  {
+    error = deflateNoCompression(out, in, insize, last);
+    if(!error && !last)
+    {
+      /*stored blocks are byte aligned already: BFINAL 0, BTYPE 00, padding, LEN 0, NLEN 0xffff*/
+      ucvector_push_back(out, 0);
+      ucvector_push_back(out, 0); ucvector_push_back(out, 0);
+      ucvector_push_back(out, 255); ucvector_push_back(out, 255);
+    }
+    return error;
+  }
   else if(settings->btype == 1) blocksize = insize;
   else /*if(settings->btype == 2)*/
   {
@@ -2049,7 +2123,7 @@ static unsigned lodepng_deflatev(ucvector* out, const unsigned char* in, size_t
 
   for(i = 0; i != numdeflateblocks && !error; ++i)
   {
-    unsigned final = (i == numdeflateblocks - 1);
+    unsigned final = last && (i == numdeflateblocks - 1);
     size_t start = i * blocksize;
     size_t end = start + blocksize;
     if(end > insize) end = insize;
@@ -2060,17 +2134,32 @@ static unsigned lodepng_deflatev(ucvector* out, const unsigned char* in, size_t
 
   hash_cleanup(&hash);
 
+  if(!error && !last)
+  {
+    /*empty stored block: BFINAL 0, BTYPE 00, padding to the byte boundary, LEN 0, NLEN 0xffff*/
+    addBitsToStream(&bp, out, 0, 3);
+    ucvector_push_back(out, 0); ucvector_push_back(out, 0);
+    ucvector_push_back(out, 255); ucvector_push_back(out, 255);
+  }
+
   return error;
 }
 
 unsigned lodepng_deflate(unsigned char** out, size_t* outsize,
                          const unsigned char* in, size_t insize,
                          const LodePNGCompressSettings* settings)
+{
+  return lodepng_deflate_chunk(out, outsize, in, insize, settings, 1);
+}
+
+unsigned lodepng_deflate_chunk(unsigned char** out, size_t* outsize,
+                               const unsigned char* in, size_t insize,
+                               const LodePNGCompressSettings* settings, unsigned last)
 {
   unsigned error;
   ucvector v;
   ucvector_init_buffer(&v, *out, *outsize);
-  error = lodepng_deflatev(&v, in, insize, settings);
+  error = lodepng_deflatev(&v, in, insize, settings, last);
   *out = v.data;
   *outsize = v.size;
   return error;
@@ -2106,6 +2195,47 @@ static unsigned update_adler32(unsigned adler, const unsigned char* data, unsign
     /*at least 5552 sums can be done before the sums overflow, saving a lot of module divisions*/
     unsigned amount = len > 5552 ? 5552 : len;
     len -= amount;
+    /*16 bytes at a time: s2 gains 16 * s1 plus the bytes weighted 16..1, which breaks up the serial
+    dependency of the byte loop. 5552 is a multiple of 16, so only the last block has a tail.*/
+#if defined(__SSE2__)
+    if(amount >= 16)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i weightsLo = _mm_set_epi16(9, 10, 11, 12, 13, 14, 15, 16);
+      const __m128i weightsHi = _mm_set_epi16(1, 2, 3, 4, 5, 6, 7, 8);
+      __m128i vs1 = zero, vprev = zero, vs2 = zero;
+      unsigned blocks = amount / 16, b, lanes1[4], lanesPrev[4], lanes2[4];
+      for(b = 0; b != blocks; ++b)
+      {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(data + 16 * b));
+        vprev = _mm_add_epi32(vprev, vs1); /*the byte sums of all earlier blocks, once per block*/
+        vs1 = _mm_add_epi32(vs1, _mm_sad_epu8(bytes, zero));
+        vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_unpacklo_epi8(bytes, zero), weightsLo));
+        vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_unpackhi_epi8(bytes, zero), weightsHi));
+      }
+      _mm_storeu_si128((__m128i*)lanes1, vs1);
+      _mm_storeu_si128((__m128i*)lanesPrev, vprev);
+      _mm_storeu_si128((__m128i*)lanes2, vs2);
+      s2 += 16 * blocks * s1 + 16 * (lanesPrev[0] + lanesPrev[2])
+          + lanes2[0] + lanes2[1] + lanes2[2] + lanes2[3];
+      s1 += lanes1[0] + lanes1[2];
+      data += 16 * blocks;
+      amount -= 16 * blocks;
+    }
+#endif
+    while(amount >= 16)
+    {
+      unsigned sum = 0, weighted = 0, i;
+      for(i = 0; i != 16; ++i)
+      {
+        sum += data[i];
+        weighted += (16 - i) * data[i];
+      }
+      s2 += 16 * s1 + weighted;
+      s1 += sum;
+      data += 16;
+      amount -= 16;
+    }
     while(amount > 0)
     {
       s1 += (*data++);
@@ -2125,6 +2255,19 @@ static unsigned adler32(const unsigned char* data, unsigned len)
   return update_adler32(1L, data, len);
 }
 
+unsigned lodepng_adler32_update(unsigned adler, const unsigned char* data, size_t len)
+{
+  /*update_adler32 takes an unsigned length*/
+  while(len > 0)
+  {
+    unsigned amount = len > 0x40000000u ? 0x40000000u : (unsigned)len;
+    adler = update_adler32(adler, data, amount);
+    data += amount;
+    len -= amount;
+  }
+  return adler;
+}
+
 /* ////////////////////////////////////////////////////////////////////////// */
 /* / Zlib                                                                   / */
 /* ////////////////////////////////////////////////////////////////////////// */
@@ -2363,11 +2506,38 @@ static unsigned lodepng_crc32_table[256] = {
   3009837614u, 3294710456u, 1567103746u,  711928724u, 3020668471u, 3272380065u, 1510334235u,  755167117u
 };
 
+/*
+Tables for slicing-by-8: slices[k][i] is the CRC of byte i followed by k zero bytes, so 8 input bytes
+can be folded in with 8 independent lookups.
+*/
+struct LodePNGCRCSlices
+{
+  unsigned t[8][256];
+  LodePNGCRCSlices()
+  {
+    unsigned i, k;
+    for(i = 0; i != 256; ++i) t[0][i] = lodepng_crc32_table[i];
+    for(k = 1; k != 8; ++k)
+    {
+      for(i = 0; i != 256; ++i) t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+    }
+  }
+};
+static const LodePNGCRCSlices lodepng_crc32_slices;
+
 /*Return the CRC of the bytes buf[0..len-1].*/
 unsigned lodepng_crc32(const unsigned char* data, size_t length)
 {
+  const unsigned (*t)[256] = lodepng_crc32_slices.t;
   unsigned r = 0xffffffffu;
   size_t i;
+  for(; length >= 8; length -= 8, data += 8)
+  {
+    unsigned a = r ^ (data[0] | ((unsigned)data[1] << 8) | ((unsigned)data[2] << 16) | ((unsigned)data[3] << 24));
+    unsigned b = data[4] | ((unsigned)data[5] << 8) | ((unsigned)data[6] << 16) | ((unsigned)data[7] << 24);
+    r = t[7][a & 0xff] ^ t[6][(a >> 8) & 0xff] ^ t[5][(a >> 16) & 0xff] ^ t[4][a >> 24]
+      ^ t[3][b & 0xff] ^ t[2][(b >> 8) & 0xff] ^ t[1][(b >> 16) & 0xff] ^ t[0][b >> 24];
+  }
   for(i = 0; i < length; ++i)
   {
     r = lodepng_crc32_table[(r ^ data[i]) & 0xff] ^ (r >> 8);
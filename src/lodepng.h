@@ -791,6 +791,18 @@ unsigned lodepng_deflate(unsigned char** out, size_t* outsize,
                          const unsigned char* in, size_t insize,
                          const LodePNGCompressSettings* settings);
 
+/*
+Like lodepng_deflate, for one chunk of a stream that is compressed in pieces. Unless last is set, no
+block is marked final and the output ends byte aligned (with an empty stored block), so the next
+chunk's output can simply be appended. Chunks don't reference each other's data.
+*/
+unsigned lodepng_deflate_chunk(unsigned char** out, size_t* outsize,
+                               const unsigned char* in, size_t insize,
+                               const LodePNGCompressSettings* settings, unsigned last);
+
+/*Continue an Adler-32 checksum (start from 1) over more data, e.g. one chunk at a time.*/
+unsigned lodepng_adler32_update(unsigned adler, const unsigned char* data, size_t len);
+
 #endif /*LODEPNG_COMPILE_ENCODER*/
 #endif /*LODEPNG_COMPILE_ZLIB*/
 
@@ -4,9 +4,11 @@
 
 #include "starter_canvas.h"
 #include "include/GShader.h"
+#include "include/GImageCache.h"
 #include <algorithm>
 #include "include/GMath.h"
 #include "TriShader_Factory.h"
+#include "GStroker.h"
 
 using BlendFunc = GPixel (GPixel, int, int, int, int);
 
@@ -353,102 +355,19 @@ GPoint makePoint(float x, float y) {
 /**
  * Calls makeEdge and turns Edge -> PathEdge
  */
-PathEdge makePathEdge(float x0, float y0, float x1, float y1, int direction, int canvasRight) {
+PathEdge makePathEdge(float x0, float y0, float x1, float y1, int direction) {
     Edge e = makeEdge(x0, y0, x1, y1);
-
-    // To-do: determine potential out-of-bounds due to y rounding in main edge loop instead
-    float new_x0 = e.mx * e.y0_round + e.bx;
-    float new_x1 = e.mx * e.y1_round + e.bx;
-    if (new_x0 < 0 || new_x0 > canvasRight) {
-        e.y0_round++;
-    }
-    if (new_x1 < 0 || new_x1 > canvasRight) {
-        e.y1_round--;
-    }
     return {e.mx, e.bx, e.y0_round, e.y1_round, direction, 0};
 }
 
 /**
- * Note: Since edges is a linked list, binary search is not possible.
- *       If another list-type exists with built-in sort, switch to that.
- *       Alternatively, create an array of iterators that can function as a binary search?
- * Returns int: The new k (after deleting edges)
- */
-int sortFirstK(std::list<PathEdge> &edges, int k, int y) {
-    std::list<PathEdge>::iterator it = edges.begin();
-    int last_x = it->findX(y);
-    it->row_x = last_x;
-    it++;
-    for (int i = 1; i < k; i++) {
-        int current_x = it->findX(y);
-        it->row_x = current_x;
-        // Insertion Sort: If the current x is to the left of the last x.
-        if (it->y0_round == y && current_x <= last_x) {
-            // If y0_round = the current y, then delete any previous intersecting lines (to not count a 'line' twice)
-            //     otherwise, given lines (p0, p1) and (p1, p2), where y0 < y1 < y2, 'p1' will be counted twice
-            // Edge case: second polygon with (pa, p1) (p1, pb) (pb, pc) where y1 == yb [trapezoid]
-            //     will delete (p0, p1) and (pa, p1) — but not (pb, pc).
-            //     aka two edges have been deleted; # of total edges is still odd; final w = 0 not happening.
-
-            // Store the edge and delete from its current position
-            PathEdge edge = *it;
-            it = edges.erase(it);
-            // Find the new index to insert at
-            it--;
-            int newPosition = i - 1;
-            for (; newPosition > 0; newPosition--) {
-                it--;
-                if (current_x > it->row_x) {
-                    it++;
-                    break;
-                } else if (current_x == it->row_x && it->y1_round == y) {
-                    // If the lines intersect and the iterator-line ends @ the current y, delete the iterator-line.
-                    it = edges.erase(it);
-                    i--;
-                    k--;
-                }
-            }
-            // Insert at the new index
-            edges.insert(it, edge);
-            newPosition++;
-            // Move iterator back to the original position
-            for (; newPosition < i; newPosition++) {
-                it++;
-            }
-        } else if (current_x < last_x) {
-            // Store the edge and delete from its current position
-            PathEdge edge = *it;
-            it = edges.erase(it);
-            // Find the new index to insert at
-            it--;
-            int newPosition = i - 1;
-            for (; newPosition > 0; newPosition--) {
-                it--;
-                if (current_x >= it->row_x) {
-                    it++;
-                    break;
-                }
-            }
-            // Delete the edge from its current position and insert at the new index
-            edges.insert(it, edge);
-            newPosition++;
-            // Move iterator back to the original position
-            for (; newPosition < i; newPosition++) {
-                it++;
-            }
-        }
-
-        last_x = it->row_x;
-
-        it++;
-    }
-    return k;
-}
-
-/**
- * Clamps and creates PathEdge(s) from given (p0, p1). Appends to provided std::list<PathEdge>.
+ * Clamps and creates PathEdge(s) from given (p0, p1). Appends to provided std::vector<PathEdge>.
+ *
+ * Note: rows and spans are half-open, so the clip bounds are the device's width and height. Parts
+ *       left or right of the device become vertical edges on its side, split at the exact crossing
+ *       (rounding it can add a row the edge never reaches, which streaks the whole row).
  */
-int appendPathEdge(float x0, float y0, float x1, float y1, int direction, int canvasBottom, int canvasRight, std::list<PathEdge> &edges, int bottom_pixel) {
+int appendPathEdge(float x0, float y0, float x1, float y1, int direction, int canvasBottom, int canvasRight, std::vector<PathEdge> &edges, int bottom_pixel) {
     PathEdge newEdge;
     // Clipping - Vertical
     if ((y0 < 0 && y1 < 0) || (y0 > canvasBottom && y1 > canvasBottom)) {
@@ -468,7 +387,7 @@ int appendPathEdge(float x0, float y0, float x1, float y1, int direction, int ca
 
     // Clipping - Horizontal
     if (x0 < 0 && x1 < 0) {
-        newEdge = makePathEdge(0.f, y0, 0.f, y1, direction, canvasRight);
+        newEdge = makePathEdge(0.f, y0, 0.f, y1, direction);
         if (newEdge.y0_round != newEdge.y1_round) {
             edges.push_back(newEdge);
             if (newEdge.y1_round > bottom_pixel) {
@@ -477,7 +396,7 @@ int appendPathEdge(float x0, float y0, float x1, float y1, int direction, int ca
         }
         return bottom_pixel;
     } else if (x0 > canvasRight && x1 > canvasRight) {
-        newEdge = makePathEdge(canvasRight, y0, canvasRight, y1, direction, canvasRight);
+        newEdge = makePathEdge(canvasRight, y0, canvasRight, y1, direction);
         if (newEdge.y0_round != newEdge.y1_round) {
             edges.push_back(newEdge);
             if (newEdge.y1_round > bottom_pixel) {
@@ -489,17 +408,17 @@ int appendPathEdge(float x0, float y0, float x1, float y1, int direction, int ca
 
     if (x0 < 0) {
         float prevy0 = y0;
-        y0 = std::ceil(findNewA1(y0, y1, x0, x1, 0));
-        x0 = findNewA1(x0, x1, prevy0, y1, y0);
-        newEdge = makePathEdge(0.f, prevy0, 0.f, y0, direction, canvasRight);
+        y0 = std::min(std::max(findNewA1(y0, y1, x0, x1, 0), y0), y1);
+        x0 = 0;
+        newEdge = makePathEdge(0.f, prevy0, 0.f, y0, direction);
         if (newEdge.y0_round != newEdge.y1_round) {
             edges.push_back(newEdge);
         }
     } else if (x1 < 0) {
         float prevy1 = y1;
-        y1 = std::floor(findNewA1(y1, y0, x1, x0, 0));
-        x1 = findNewA1(x1, x0, prevy1, y0, y1);
-        newEdge = makePathEdge(0.f, y1, 0.f, prevy1, direction, canvasRight);
+        y1 = std::min(std::max(findNewA1(y1, y0, x1, x0, 0), y0), y1);
+        x1 = 0;
+        newEdge = makePathEdge(0.f, y1, 0.f, prevy1, direction);
         if (newEdge.y0_round != newEdge.y1_round) {
             edges.push_back(newEdge);
             if (newEdge.y1_round > bottom_pixel) {
@@ -510,17 +429,17 @@ int appendPathEdge(float x0, float y0, float x1, float y1, int direction, int ca
 
     if (x0 > canvasRight) {
         float prevy0 = y0;
-        y0 = std::ceil(findNewA1(y0, y1, x0, x1, canvasRight));
-        x0 = findNewA1(x0, x1, prevy0, y1, y0);
-        newEdge = makePathEdge(canvasRight, prevy0, canvasRight, y0, direction, canvasRight);
+        y0 = std::min(std::max(findNewA1(y0, y1, x0, x1, canvasRight), y0), y1);
+        x0 = canvasRight;
+        newEdge = makePathEdge(canvasRight, prevy0, canvasRight, y0, direction);
         if (newEdge.y0_round != newEdge.y1_round) {
             edges.push_back(newEdge);
         }
     } else if (x1 > canvasRight) {
         float prevy1 = y1;
-        y1 = std::floor(findNewA1(y1, y0, x1, x0, canvasRight));
-        x1 = findNewA1(x1, x0, prevy1, y0, y1);
-        newEdge = makePathEdge(canvasRight, y1, canvasRight, prevy1, direction, canvasRight);
+        y1 = std::min(std::max(findNewA1(y1, y0, x1, x0, canvasRight), y0), y1);
+        x1 = canvasRight;
+        newEdge = makePathEdge(canvasRight, y1, canvasRight, prevy1, direction);
         if (newEdge.y0_round != newEdge.y1_round) {
           edges.push_back(newEdge);
           if (newEdge.y1_round > bottom_pixel) {
@@ -530,7 +449,7 @@ int appendPathEdge(float x0, float y0, float x1, float y1, int direction, int ca
     }
 
     // Make Edge
-    newEdge = makePathEdge(x0, y0, x1, y1, direction, canvasRight);
+    newEdge = makePathEdge(x0, y0, x1, y1, direction);
     if (newEdge.y0_round != newEdge.y1_round) {
         edges.push_back(newEdge);
         if (newEdge.y1_round > bottom_pixel) {
@@ -541,12 +460,218 @@ int appendPathEdge(float x0, float y0, float x1, float y1, int direction, int ca
     return bottom_pixel;
 }
 
+/**
+ * Appends the edge p0 -> p1, going down (direction 1) or up (direction -1).
+ */
+int appendPathSegment(GPoint p0, GPoint p1, int canvasBottom, int canvasRight, std::vector<PathEdge> &edges, int bottom_pixel) {
+    if (p0.y < p1.y) {
+        return appendPathEdge(p0.x, p0.y, p1.x, p1.y, 1, canvasBottom, canvasRight, edges, bottom_pixel);
+    } else {
+        return appendPathEdge(p1.x, p1.y, p0.x, p0.y, -1, canvasBottom, canvasRight, edges, bottom_pixel);
+    }
+}
+
+/**
+ * Appends the device-space quadratic pts[0..2] as line segments within tolerance of the curve.
+ */
+static int appendQuadSegments(const GPoint pts[3], float tolerance, int canvasBottom, int canvasRight,
+                              std::vector<PathEdge> &edges, int bottom_pixel) {
+    // Find n = number of line segments: the error of n segments is |e0| / (4 n^2).
+    GPoint e0 = pts[0] - 2*pts[1] + pts[2];
+    float e0_dist = sqrt(pow(e0.x, 2.f) + pow(e0.y, 2.f));
+    int n = (int) ceilf(sqrt(e0_dist / (4 * tolerance)));
+
+    // Ensure n is a valid number to loop over
+    if (n > 1) {
+        GPoint c_1 = 2*(pts[1] - pts[0]);
+
+        // Integer steps: exactly n segments, the last one ending on pts[2]
+        float dt = 1.f / n;
+        GPoint p0 = pts[0];
+        for (int i = 1; i <= n; i++) {
+            float t = i * dt;
+            GPoint p1 = (i == n) ? pts[2] : (e0*t + c_1)*t + pts[0];
+            bottom_pixel = appendPathSegment(p0, p1, canvasBottom, canvasRight, edges, bottom_pixel);
+            p0 = p1;
+        }
+        return bottom_pixel;
+    }
+    // Only drawing one line from A to C.
+    return appendPathSegment(pts[0], pts[2], canvasBottom, canvasRight, edges, bottom_pixel);
+}
+
+/**
+ * Returns true if bounds, mapped by matrix, misses device columns [0, width) and rows [top, bottom).
+ */
+static bool missesDevice(const GRect& bounds, const GMatrix& matrix, int width, int top, int bottom) {
+    GPoint corners[4] = {
+        {bounds.left, bounds.top}, {bounds.right, bounds.top},
+        {bounds.right, bounds.bottom}, {bounds.left, bounds.bottom},
+    };
+    matrix.mapPoints(corners, corners, 4);
+    float deviceLeft = std::min({corners[0].x, corners[1].x, corners[2].x, corners[3].x});
+    float deviceRight = std::max({corners[0].x, corners[1].x, corners[2].x, corners[3].x});
+    float deviceTop = std::min({corners[0].y, corners[1].y, corners[2].y, corners[3].y});
+    float deviceBottom = std::max({corners[0].y, corners[1].y, corners[2].y, corners[3].y});
+    return deviceRight < 0 || deviceLeft > width || deviceBottom < top || deviceTop > bottom;
+}
+
+/**
+ * Fills the edges (already clipped to the device) using non-zero winding, writing rows
+ * [top, top + device.height()) into device. A null shader means the edges are filled with color.
+ *
+ * Note: an edge covers rows [y0_round, y1_round), sampled at the pixel centers, so edges that
+ *       meet at a vertex (from any contour) never count twice in the same row. Each row only
+ *       depends on the edges that cover it, so starting at top fills it as a full render would.
+ */
+static void fillPathEdges(const GBitmap& device, int top, std::vector<PathEdge> &edges, int bottom_pixel,
+                          GShader* shader, const GColor& color, GBlendMode blendMode) {
+    if (edges.size() < 2) {
+        return;
+    }
+
+    // Sort edges
+    std::sort(edges.begin(), edges.end());
+
+    // Select the span fill for this paint
+    BlendFunc* blendFunc = getBlendFunc(blendMode);
+    GPixel newPixel = (blendMode == GBlendMode::kClear) ? GPixel_PackARGB(0, 0, 0, 0) : GColorToGPixel(color);
+    int a = GRoundToInt(color.a * 255);
+    int r = GRoundToInt(color.r * 255 * color.a);
+    int g = GRoundToInt(color.g * 255 * color.a);
+    int b = GRoundToInt(color.b * 255 * color.a);
+    bool useShader = shader != nullptr && blendMode != GBlendMode::kClear;
+    std::vector<GPixel> shaderRow;
+
+    auto fillSpan = [&](int left_pixel, int y, int width) {
+        GPixel* pixelRow = device.getAddr(left_pixel, y - top);
+        if (useShader) {
+            // if GShader replaces existing pixels, shade straight into the device.
+            if (blendMode == GBlendMode::kSrc) {
+                shader->shadeRow(left_pixel, y, width, pixelRow);
+                return;
+            }
+            if ((int) shaderRow.size() < width) {
+                shaderRow.resize(width);
+            }
+            shader->shadeRow(left_pixel, y, width, shaderRow.data());
+            for (int j = 0; j < width; j++) {
+                pixelRow[j] = blendFunc(
+                    pixelRow[j],
+                    GPixel_GetA(shaderRow[j]),
+                    GPixel_GetR(shaderRow[j]),
+                    GPixel_GetG(shaderRow[j]),
+                    GPixel_GetB(shaderRow[j])
+                );
+            }
+        } else if (blendMode == GBlendMode::kClear || blendMode == GBlendMode::kSrc) {
+            for (int j = 0; j < width; j++) {
+                pixelRow[j] = newPixel;
+            }
+        } else {
+            for (int j = 0; j < width; j++) {
+                pixelRow[j] = blendFunc(pixelRow[j], a, r, g, b);
+            }
+        }
+    };
+
+    // Walk the rows, keeping the active edges sorted by x
+    int canvasWidth = device.width();
+    int bottom = std::min(bottom_pixel, top + device.height());
+    std::vector<PathEdge> active;
+    size_t next = 0;
+    for (int y = std::max(edges.front().y0_round, top); y < bottom; y++) {
+        // Drop finished edges, then add edges that start on this row
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [y](const PathEdge& e) { return e.y1_round <= y; }),
+                     active.end());
+        while (next < edges.size() && edges[next].y0_round <= y) {
+            if (edges[next].y1_round > y) {
+                active.push_back(edges[next]);
+            }
+            next++;
+        }
+        if (active.empty()) {
+            if (next == edges.size()) {
+                break;
+            }
+            continue;
+        }
+
+        // Find x at the pixel center; insertion sort (the order barely changes between rows)
+        float center_y = y + 0.5f;
+        for (size_t i = 0; i < active.size(); i++) {
+            PathEdge edge = active[i];
+            edge.row_x = GRoundToInt(edge.mx * center_y + edge.bx);
+            size_t j = i;
+            for (; j > 0 && active[j - 1].row_x > edge.row_x; j--) {
+                active[j] = active[j - 1];
+            }
+            active[j] = edge;
+        }
+
+        // Fill wherever the winding is non-zero
+        int w = 0;
+        int left_pixel = 0;
+        for (const PathEdge& edge : active) {
+            if (w == 0) {
+                left_pixel = edge.row_x;
+            }
+            w += edge.direction;
+            if (w == 0) {
+                int left = std::max(left_pixel, 0);
+                int right = std::min(edge.row_x, canvasWidth);
+                if (right > left) {
+                    fillSpan(left, y, right - left);
+                }
+            }
+        }
+    }
+}
+
 
+// OPACITY TRACKING
+void MyCanvas::setOpaque(bool isOpaque) {
+    fIsOpaque = isOpaque;
+    if (fOwner) {
+        fOwner->setIsOpaque(isOpaque ? GBitmap::kYes_IsOpaque : GBitmap::kNo_IsOpaque);
+    }
+}
+
+/*
+ * An opaque device stays opaque under modes whose result alpha is Da, or 1 when Da is 1; the
+ * modes whose result alpha is Sa need an opaque source. Draws never make a device opaque here,
+ * except for a full-device kSrc rect (see drawRect).
+ */
+void MyCanvas::noteBlend(GBlendMode blendMode, bool srcIsOpaque) {
+    if (!fIsOpaque) {
+        return;
+    }
+    switch (blendMode) {
+        case GBlendMode::kDst:
+        case GBlendMode::kSrcOver:
+        case GBlendMode::kDstOver:
+        case GBlendMode::kSrcATop:
+            return;
+        case GBlendMode::kSrc:
+        case GBlendMode::kSrcIn:
+        case GBlendMode::kDstIn:
+        case GBlendMode::kDstATop:
+            if (srcIsOpaque) {
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    this->setOpaque(false);
+}
 
 // ASSIGNMENT FUNCTIONS
 void MyCanvas::clear(const GColor& color) {
     // GColor -> GPixel
     GPixel newPixel = GColorToGPixel(color);
+    this->setOpaque(GPixel_GetA(newPixel) == 0xFF);
 
     int height = fDevice.height();
     int width = fDevice.width();
@@ -572,6 +697,7 @@ void MyCanvas::drawRect(const GRect& rect, const GPaint& paint) {
     } else {
         blendMode = simplifyBlendMode(blendMode, color.a);
     }
+    this->noteBlend(blendMode, useShader ? shader->isOpaque() : color.a >= 1.f);
 
     // If rectangle makes no impact, terminate early.
     if (blendMode == GBlendMode::kDst) {
@@ -580,38 +706,36 @@ void MyCanvas::drawRect(const GRect& rect, const GPaint& paint) {
 
     // If no transform is being performed, use rectangle sides; else, use transformed points.
     int left_border, right_border, top_border, bottom_border;
-    if (currentMatrix == GMatrix()) {
+    if (currentMatrix.isIdentity()) {
         left_border = GRoundToInt(rect.left);
         right_border = GRoundToInt(rect.right);
         top_border = GRoundToInt(rect.top);
         bottom_border = GRoundToInt(rect.bottom);
+    } else if (currentMatrix.isScaleTranslate()) {
+        // Scale + translate keeps the rect axis-aligned: only the two opposite corners are needed.
+        GPoint corners[2] = {makePoint(rect.left, rect.top), makePoint(rect.right, rect.bottom)};
+        currentMatrix.mapPoints(corners, corners, 2);
+
+        left_border = GRoundToInt(std::min(corners[0].x, corners[1].x));
+        right_border = GRoundToInt(std::max(corners[0].x, corners[1].x));
+        top_border = GRoundToInt(std::min(corners[0].y, corners[1].y));
+        bottom_border = GRoundToInt(std::max(corners[0].y, corners[1].y));
     } else {
-        // Transform points
+        // Rotation / skew: no longer (necessarily) an axis-aligned rectangle, so call drawPolygon().
         GPoint points[4];
         points[0] = makePoint(rect.left, rect.top);
         points[1] = makePoint(rect.right, rect.top);
         points[2] = makePoint(rect.right, rect.bottom);
         points[3] = makePoint(rect.left, rect.bottom);
-        GPoint transformPoints[3];
-        currentMatrix.mapPoints(transformPoints, points, 3);
-
-        // If transform causes shape to no longer be a rectangle (or rotates 90/270), call drawPolygon().
-        if (transformPoints[0].y != transformPoints[1].y || transformPoints[1].x != transformPoints[2].x) {
-            drawConvexPolygon(points, 4, paint);
-            return;
-        }
-
-        left_border = GRoundToInt(std::min(transformPoints[0].x, transformPoints[1].x));
-        right_border = GRoundToInt(std::max(transformPoints[0].x, transformPoints[1].x));
-        top_border = GRoundToInt(std::min(transformPoints[0].y, transformPoints[2].y));
-        bottom_border = GRoundToInt(std::max(transformPoints[0].y, transformPoints[2].y));
+        drawConvexPolygon(points, 4, paint);
+        return;
     }
 
     // Check if rect is out-of-bounds or has a width/height of 0
     if (left_border >= fDevice.width()
         || right_border <= 0
-        || top_border >= fDevice.height()
-        || bottom_border <= 0
+        || top_border >= fTop + fDevice.height()
+        || bottom_border <= fTop
         || left_border == right_border
         || top_border == bottom_border) {
         return;
@@ -620,8 +744,15 @@ void MyCanvas::drawRect(const GRect& rect, const GPaint& paint) {
     // Isolate drawn rectangle to the overlapping area between rect and fDevice
     left_border = std::max(left_border, 0);
     right_border = std::min(right_border, fDevice.width());
-    top_border = std::max(top_border, 0);
-    bottom_border = std::min(bottom_border, fDevice.height());
+    top_border = std::max(top_border, fTop);
+    bottom_border = std::min(bottom_border, fTop + fDevice.height());
+
+    // An opaque source replacing every pixel leaves the device opaque (e.g. a background rect)
+    if (blendMode == GBlendMode::kSrc && (useShader ? shader->isOpaque() : color.a >= 1.f)
+        && left_border == 0 && top_border == fTop
+        && right_border == fDevice.width() && bottom_border == fTop + fDevice.height()) {
+        this->setOpaque(true);
+    }
 
     // GShader vs GColor; draw rectangle.
     if (useShader && blendMode != GBlendMode::kClear) {
@@ -629,7 +760,7 @@ void MyCanvas::drawRect(const GRect& rect, const GPaint& paint) {
         // if GShader replaces existing pixels, deploy a faster for-loop.
         if (blendMode == GBlendMode::kSrc) {
             for (int y = top_border; y < bottom_border; y++) {
-                GPixel* pixelRow = fDevice.getAddr(left_border, y);
+                GPixel* pixelRow = getAddr(left_border, y);
                 GPixel shaderRow[width];
                 shader->shadeRow(left_border, y, width, shaderRow);
                 for (int i = 0; i < width; i++) {
@@ -640,7 +771,7 @@ void MyCanvas::drawRect(const GRect& rect, const GPaint& paint) {
             BlendFunc* blendFunc = getBlendFunc(blendMode);
 
             for (int y = top_border; y < bottom_border; y++) {
-                GPixel* pixelRow = fDevice.getAddr(left_border, y);
+                GPixel* pixelRow = getAddr(left_border, y);
                 GPixel shaderRow[width];
                 shader->shadeRow(left_border, y, width, shaderRow);
                 for (int i = 0; i < width; i++) {
@@ -659,7 +790,7 @@ void MyCanvas::drawRect(const GRect& rect, const GPaint& paint) {
         if (blendMode == GBlendMode::kClear || blendMode == GBlendMode::kSrc) {
             GPixel newPixel = (blendMode == GBlendMode::kClear) ? GPixel_PackARGB(0, 0, 0, 0) : GColorToGPixel(color);
             for (int y = top_border; y < bottom_border; y++) {
-        	    GPixel* pixelRow = fDevice.getAddr(left_border, y);
+        	    GPixel* pixelRow = getAddr(left_border, y);
         	    for (int x = left_border; x < right_border; x++) {
             	    *pixelRow = newPixel;
             	    pixelRow++;
@@ -675,7 +806,7 @@ void MyCanvas::drawRect(const GRect& rect, const GPaint& paint) {
             BlendFunc* blendFunc = getBlendFunc(blendMode);
 
     	    for (int y = top_border; y < bottom_border; y++) {
-        	    GPixel* pixelRow = fDevice.getAddr(left_border, y);
+        	    GPixel* pixelRow = getAddr(left_border, y);
         	    for (int x = left_border; x < right_border; x++) {
             	    *pixelRow = blendFunc(*pixelRow, a, r, g, b);
             	    pixelRow++;
@@ -703,6 +834,7 @@ void MyCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint&
     } else {
         blendMode = simplifyBlendMode(blendMode, color.a);
     }
+    this->noteBlend(blendMode, useShader ? shader->isOpaque() : color.a >= 1.f);
 
     // Terminate if kDst.
     if (blendMode == GBlendMode::kDst) {
@@ -714,9 +846,10 @@ void MyCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint&
     GPoint newPoints[count];
     currentMatrix.mapPoints(newPoints, points, count);
 
-    // Create list of edges, determine bottom_pixel
-    int canvasBottom = fDevice.height() - 1;
-    int canvasRight = fDevice.width() - 1;
+    // Create list of edges, determine bottom_pixel. Rows and spans are half-open, so edges are
+    // clipped to the device's width and height (not width-1/height-1, which skips the last row and column).
+    int canvasBottom = fHeight;
+    int canvasRight = fDevice.width();
 
     float x0, y0, x1, y1;
 
@@ -852,6 +985,9 @@ void MyCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint&
     Edge edge2 = *it;
     int top_pixel = std::max(edge1.y0_round, edge2.y0_round);
 
+    // Only rows in the device are drawn, but the edges are walked from top_pixel as on a full canvas.
+    bottom_pixel = std::min(bottom_pixel, fTop + fDevice.height());
+
 
     // GShader vs GColor; draw polygon.
     if (useShader && blendMode != GBlendMode::kClear) {
@@ -867,6 +1003,9 @@ void MyCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint&
                     it++;
                     edge2 = *it;
                 }
+                if (y < fTop) {
+                    continue;
+                }
                 // Determine left_pixel, right_pixel; obtain shaderRow.
                 int pixel_x1 = edge1.findX(y);
                 int pixel_x2 = edge2.findX(y);
@@ -876,7 +1015,7 @@ void MyCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint&
                 if (width == 0) {
                     continue;
                 }
-                GPixel* pixelRow = fDevice.getAddr(left_pixel, y);
+                GPixel* pixelRow = getAddr(left_pixel, y);
                 shader->shadeRow(left_pixel, y, width, pixelRow);
             }
         } else {
@@ -892,6 +1031,9 @@ void MyCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint&
                     it++;
                     edge2 = *it;
                 }
+                if (y < fTop) {
+                    continue;
+                }
                 // Determine left_pixel, right_pixel; obtain shaderRow.
                 int pixel_x1 = edge1.findX(y);
                 int pixel_x2 = edge2.findX(y);
@@ -902,7 +1044,7 @@ void MyCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint&
                     continue;
                 }
 
-                GPixel* pixelRow = fDevice.getAddr(left_pixel, y);
+                GPixel* pixelRow = getAddr(left_pixel, y);
                 GPixel shaderRow[width];
                 shader->shadeRow(left_pixel, y, width, shaderRow);
                 for (int i = 0; i < width; i++) {
@@ -931,6 +1073,9 @@ void MyCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint&
                     it++;
                     edge2 = *it;
                 }
+                if (y < fTop) {
+                    continue;
+                }
                 // Determine left_pixel, right_pixel
                 int pixel_x1 = GRoundToInt(edge1.mx * y + edge1.bx);
                 int pixel_x2 = GRoundToInt(edge2.mx * y + edge2.bx);
@@ -938,7 +1083,7 @@ void MyCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint&
                 int right_pixel = std::max(pixel_x1, pixel_x2);
 
                 // Find and loop through pixelRow
-        	    GPixel* pixelRow = fDevice.getAddr(left_pixel, y);
+        	    GPixel* pixelRow = getAddr(left_pixel, y);
                 for (int x = left_pixel; x < right_pixel; x++) {
             	    *pixelRow = newPixel;
             	    pixelRow++;
@@ -963,6 +1108,9 @@ void MyCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint&
                     it++;
                     edge2 = *it;
                 }
+                if (y < fTop) {
+                    continue;
+                }
                 // Determine left_pixel, right_pixel
                 int pixel_x1 = GRoundToInt(edge1.mx * y + edge1.bx);
                 int pixel_x2 = GRoundToInt(edge2.mx * y + edge2.bx);
@@ -970,7 +1118,7 @@ void MyCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint&
                 int right_pixel = std::max(pixel_x1, pixel_x2);
 
                 // Find and loop through pixelRow
-        	    GPixel* pixelRow = fDevice.getAddr(left_pixel, y);
+        	    GPixel* pixelRow = getAddr(left_pixel, y);
         	    for (int x = left_pixel; x < right_pixel; x++) {
             	    *pixelRow = blendFunc(*pixelRow, a, r, g, b);
             	    pixelRow++;
@@ -1000,6 +1148,7 @@ void MyCanvas::drawPath(const GPath& path, const GPaint& paint) {
     } else {
         blendMode = simplifyBlendMode(blendMode, color.a);
     }
+    this->noteBlend(blendMode, useShader ? shader->isOpaque() : color.a >= 1.f);
 
     // Terminate if kDst.
     if (blendMode == GBlendMode::kDst) {
@@ -1008,329 +1157,154 @@ void MyCanvas::drawPath(const GPath& path, const GPaint& paint) {
 
 
 
-    // Transform points according to currentMatrix.
-    std::shared_ptr<GPath> transformPath = path.transform(currentMatrix);
+    // Terminate if the (cached) path bounds, mapped to the device, miss the canvas.
+    if (missesDevice(path.bounds(), currentMatrix, fDevice.width(), fTop, fTop + fDevice.height())) {
+        return;
+    }
 
     // Create list of edges, determine bottom_pixel
-    int canvasBottom = fDevice.height() - 1;
-    int canvasRight = fDevice.width() - 1;
+    int canvasBottom = fHeight;
+    int canvasRight = fDevice.width();
 
     int bottom_pixel = 0;
 
-    std::list<PathEdge> edges;
+    std::vector<PathEdge> edges;
+    float tolerance = paint.getTolerance();
     GPoint pts[GPath::kMaxNextPoints];
-    GPath::Edger edger(*transformPath);
+    // Points are mapped by currentMatrix as they are read (no transformed copy of the path).
+    GPath::Edger edger(path, currentMatrix);
 
     while (auto v = edger.next(pts)) {
         if (v.value() == GPathVerb::kLine) {
-            // Init p0, p1 for the new edge
-            if (pts[0].y < pts[1].y) {
-            	bottom_pixel = appendPathEdge(pts[0].x, pts[0].y, pts[1].x, pts[1].y, 1, canvasBottom, canvasRight, edges, bottom_pixel);
-            } else {
-            	bottom_pixel = appendPathEdge(pts[1].x, pts[1].y, pts[0].x, pts[0].y, -1, canvasBottom, canvasRight, edges, bottom_pixel);
-            }
+            bottom_pixel = appendPathSegment(pts[0], pts[1], canvasBottom, canvasRight, edges, bottom_pixel);
         } else if (v.value() == GPathVerb::kQuad) {
-            // Find n = number of line segments
-            GPoint e0 = pts[0] - 2*pts[1] + pts[2];  // no /4 because /Tolerance = *4.
-            float e0_dist = sqrt(pow(e0.x, 2.f) + pow(e0.y, 2.f));
-            float n = ceilf(sqrt(e0_dist));
-
-            // Ensure n is a valid number to loop over
-            if (n > 1) {
-                GPoint c_1 = 2*(pts[1] - pts[0]);
-
-                float dt = 1.f / n;
-                GPoint p0 = pts[0];
-                for (float t = dt; t <= 1; t += dt) {
-                    GPoint p1 = (e0*t + c_1)*t + pts[0];
-                    if (p0.y < p1.y) {
-                        bottom_pixel = appendPathEdge(p0.x, p0.y, p1.x, p1.y, 1, canvasBottom, canvasRight, edges, bottom_pixel);
-                    } else {
-                        bottom_pixel = appendPathEdge(p1.x, p1.y, p0.x, p0.y, -1, canvasBottom, canvasRight, edges, bottom_pixel);
-                    }
-                    p0 = p1;
-                }
-            } else {
-                // Only drawing one line from A to C.
-                if (pts[0].y < pts[2].y) {
-                    bottom_pixel = appendPathEdge(pts[0].x, pts[0].y, pts[2].x, pts[2].y, 1, canvasBottom, canvasRight, edges, bottom_pixel);
-                } else {
-                    bottom_pixel = appendPathEdge(pts[2].x, pts[2].y, pts[0].x, pts[0].y, -1, canvasBottom, canvasRight, edges, bottom_pixel);
-                }
-            }
+            bottom_pixel = appendQuadSegments(pts, tolerance, canvasBottom, canvasRight, edges, bottom_pixel);
         } else if (v.value() == GPathVerb::kCubic) {
+            // Find n = number of line segments: with E the larger second difference of the control
+            // points, n segments stay within 3E / (4 n^2) of the curve.
+            GPoint d0 = pts[0] - 2*pts[1] + pts[2];
+            GPoint d1 = pts[1] - 2*pts[2] + pts[3];
+            float e = std::max(sqrt(d0.x*d0.x + d0.y*d0.y), sqrt(d1.x*d1.x + d1.y*d1.y));
+            int n = (int) ceilf(sqrt(3 * e / (4 * tolerance)));
             GPoint c_3 = 3*pts[1] - pts[0] - 3*pts[2] + pts[3];
-            GPoint e0 = c_3 * 0.5f;  // no /8 because /Tolerance = *4; 3 / 2 = 1.5
-            float e0_dist = sqrt(pow(e0.x, 2.f) + pow(e0.y, 2.f));
-            float n = ceilf(sqrt(e0_dist));
 
 			// Ensure n is a valid number to loop over
             if (n > 1) {
                 GPoint c_1 = 3*(pts[1] - pts[0]);
                 GPoint c_2 = 3*(pts[0] - 2*pts[1] + pts[2]);
 
+                // Integer steps: exactly n segments, the last one ending on pts[3]
                 float dt = 1.f / n;
                 GPoint p0 = pts[0];
-                for (float t = dt; t <= 1; t += dt) {
-                    GPoint p1 = ((c_3*t + c_2)*t + c_1)*t + pts[0];
-                    if (p0.y < p1.y) {
-                        bottom_pixel = appendPathEdge(p0.x, p0.y, p1.x, p1.y, 1, canvasBottom, canvasRight, edges, bottom_pixel);
-                    } else {
-                        bottom_pixel = appendPathEdge(p1.x, p1.y, p0.x, p0.y, -1, canvasBottom, canvasRight, edges, bottom_pixel);
-                    }
+                for (int i = 1; i <= n; i++) {
+                    float t = i * dt;
+                    GPoint p1 = (i == n) ? pts[3] : ((c_3*t + c_2)*t + c_1)*t + pts[0];
+                    bottom_pixel = appendPathSegment(p0, p1, canvasBottom, canvasRight, edges, bottom_pixel);
                     p0 = p1;
                 }
             } else {
                 // Only drawing one line from A to D.
-                if (pts[0].y < pts[3].y) {
-                    bottom_pixel = appendPathEdge(pts[0].x, pts[0].y, pts[3].x, pts[3].y, 1, canvasBottom, canvasRight, edges, bottom_pixel);
-                } else {
-                    bottom_pixel = appendPathEdge(pts[3].x, pts[3].y, pts[0].x, pts[0].y, -1, canvasBottom, canvasRight, edges, bottom_pixel);
-                }
+                bottom_pixel = appendPathSegment(pts[0], pts[3], canvasBottom, canvasRight, edges, bottom_pixel);
             }
         }
     }
 
-    if (edges.size() < 2) {
-        return;
-    }
-
+    fillPathEdges(fDevice, fTop, edges, bottom_pixel, useShader ? shader : nullptr, color, blendMode);
+}
 
+/**
+ * Turns a stroke outline into device edges as it is generated: points are mapped by the CTM and
+ * arcs flattened right away, so no GPath is built.
+ */
+class EdgeStrokeSink : public GStrokeSink {
+public:
+    EdgeStrokeSink(const GMatrix& matrix, float tolerance, int canvasBottom, int canvasRight)
+        : fMatrix(matrix), fTolerance(tolerance), fCanvasBottom(canvasBottom), fCanvasRight(canvasRight) {}
+
+    void moveTo(GPoint p) override {
+        this->closeContour();
+        fStart = fLast = fMatrix * p;
+    }
 
-    // Sort edges
-    edges.sort();
+    void lineTo(GPoint p) override {
+        GPoint next = fMatrix * p;
+        bottom_pixel = appendPathSegment(fLast, next, fCanvasBottom, fCanvasRight, edges, bottom_pixel);
+        fLast = next;
+    }
 
+    void quadTo(GPoint p1, GPoint p2) override {
+        GPoint pts[3] = {fLast, fMatrix * p1, fMatrix * p2};
+        bottom_pixel = appendQuadSegments(pts, fTolerance, fCanvasBottom, fCanvasRight, edges, bottom_pixel);
+        fLast = pts[2];
+    }
 
-    // Determine top_pixel, k
-    int top_pixel = edges.front().y0_round;
-    int k = 0;
-    for (auto it = edges.begin(); it != edges.end(); it++) {
-      if (it->y0_round > top_pixel) {
-        break;
-      }
-      k++;
+    // Contours are implicitly closed: adds the line back to the start of the current one.
+    void closeContour() {
+        if (fLast != fStart) {
+            bottom_pixel = appendPathSegment(fLast, fStart, fCanvasBottom, fCanvasRight, edges, bottom_pixel);
+        }
+        fLast = fStart;
     }
 
+    std::vector<PathEdge> edges;
+    int bottom_pixel = 0;
 
-    // GShader vs GColor; draw polygon.
-    if (useShader && blendMode != GBlendMode::kClear) {
-        // if GShader replaces existing pixels, deploy a faster for-loop.
-        if (blendMode == GBlendMode::kSrc) {
-            for (int y = top_pixel; y < bottom_pixel; y++) {
-                std::list<PathEdge>::iterator it;
-                if (k > 0) {
-                    // Sort the first k edges by x
-                    k = sortFirstK(edges, k, y);
-                    // Loop through edges
-                    it = edges.begin();
-                    int w = 0;
-                    int left_pixel, width;
-                    int iMax = k;
-                    for (int i = 0; i < iMax; i++) {
-                        int edge_x = it->row_x;
-                        // If left pixel, instantiate
-                        if (w == 0) {
-                            left_pixel = edge_x;
-                        }
-                        w += it->direction;
-                        // If row segment is over and width > 0, fill.
-                        if (w == 0 && (width = edge_x - left_pixel) > 0) {
-                            // Obtain pixelRow, shaderRow.
-                            GPixel* pixelRow = fDevice.getAddr(left_pixel, y);
-                            shader->shadeRow(left_pixel, y, width, pixelRow);
-                        }
-                        // If edge is valid, it++; else, remove
-                        if (it->isValid(y+1)) {
-                            it++;
-                        } else {
-                            it = edges.erase(it);
-                            k--;
-                        }
-                    }
-                } else {
-                    it = edges.begin();
-                }
+private:
+    const GMatrix& fMatrix;
+    const float fTolerance;
+    const int fCanvasBottom, fCanvasRight;
+    GPoint fStart = {0, 0}, fLast = {0, 0};
+};
 
-                // Loop through the remaining elements and increment k as necessary
-                while (it != edges.end()) {
-                    if (it->isValid(y+1)) {
-                        k++;
-                        it++;
-                    } else {
-                        break;
-                    }
-                }
-            }
-        } else {
-            BlendFunc* blendFunc = getBlendFunc(blendMode);
+void MyCanvas::drawStrokePolygon(const GPoint points[], int count, float width, bool isClosed, const GPaint& paint) {
+    // Terminate if invalid stroke
+    if (count < 2 || width <= 0.f) {
+        return;
+    }
 
-            for (int y = top_pixel; y < bottom_pixel; y++) {
-                std::list<PathEdge>::iterator it;
-                if (k > 0) {
-                    // Sort the first k edges by x
-                    k = sortFirstK(edges, k, y);
-                    // Loop through edges
-                    it = edges.begin();
-                    int w = 0;
-                    int left_pixel, width;
-                    int iMax = k;
-                    for (int i = 0; i < iMax; i++) {
-                        int edge_x = it->row_x;
-                        // If left pixel, instantiate
-                        if (w == 0) {
-                            left_pixel = edge_x;
-                        }
-                        w += it->direction;
-                        // If row segment is over and width > 0, fill.
-                        if (w == 0 && (width = edge_x - left_pixel) > 0) {
-                            // Obtain pixelRow, shaderRow.
-                            GPixel* pixelRow = fDevice.getAddr(left_pixel, y);
-                            GPixel shaderRow[width];
-                            shader->shadeRow(left_pixel, y, width, shaderRow);
-                            // Fill in the row segment
-                            for (int j = 0; j < width; j++) {
-                                pixelRow[j] = blendFunc(
-                                    pixelRow[j],
-                                    GPixel_GetA(shaderRow[j]),
-                                    GPixel_GetR(shaderRow[j]),
-                                    GPixel_GetG(shaderRow[j]),
-                                    GPixel_GetB(shaderRow[j])
-                                );
-                            }
-                        }
-                        // If edge is valid, it++; else, remove
-                        if (it->isValid(y+1)) {
-                            it++;
-                        } else {
-                            it = edges.erase(it);
-                            k--;
-                        }
-                    }
-                } else {
-                    it = edges.begin();
-                }
+    // Determine Shader vs Color and blendMode. Set Shader Context if applicable.
+    GShader* shader = paint.peekShader();
+    GColor color = paint.getColor();
+    bool useShader = paint.peekShader();
+    GBlendMode blendMode = paint.getBlendMode();
 
-                // Loop through the remaining elements and increment k as necessary
-                while (it != edges.end()) {
-                    if (it->isValid(y+1)) {
-                        k++;
-                        it++;
-                    } else {
-                        break;
-                    }
-                }
-            }
-        }
+    if (useShader) {
+        shader->setContext(currentMatrix);
+        blendMode = simplifyBlendMode(blendMode, shader->isOpaque());
     } else {
-        // If polygon replaces existing pixels, deploy a faster for-loop.
-        if (blendMode == GBlendMode::kClear || blendMode == GBlendMode::kSrc) {
-            GPixel newPixel = (blendMode == GBlendMode::kClear) ? GPixel_PackARGB(0, 0, 0, 0) : GColorToGPixel(color);
-
-            for (int y = top_pixel; y < bottom_pixel; y++) {
-                std::list<PathEdge>::iterator it;
-                // Perform operations if edge exists
-                if (k > 0) {
-                    // Sort the first k edges by x
-                    k = sortFirstK(edges, k, y);
-                    it = edges.begin();
-                    int w = 0;
-                    int left_pixel, width;
-                    int iMax = k;
-                    for (int i = 0; i < iMax; i++) {
-                        int edge_x = it->row_x;
-                        // If left pixel, instantiate
-                        if (w == 0) {
-                            left_pixel = edge_x;
-                        }
-                        w += it->direction;
-                        // If row segment is over and width > 0, fill.
-                        if (w == 0 && (width = edge_x - left_pixel) > 0) {
-                            // Obtain pixelRow, shaderRow.
-                            GPixel* pixelRow = fDevice.getAddr(left_pixel, y);
-                            for (int j = 0; j < width; j++) {
-                                pixelRow[j] = newPixel;
-                            }
-                        }
-                        // If edge is valid, it++; else, remove
-                        if (it->isValid(y+1)) {
-                            it++;
-                        } else {
-                            it = edges.erase(it);
-                            k--;
-                        }
-                    }
-                } else {
-                    it = edges.begin();
-                }
-
-                // Loop through the remaining elements and increment k as necessary
-                while (it != edges.end()) {
-                    if (it->isValid(y+1)) {
-                        k++;
-                        it++;
-                    } else {
-                        break;
-                    }
-                }
-            }
-        } else {
-            // GColor -> GPixel rgbint
-            int a = GRoundToInt(color.a * 255);
-            int r = GRoundToInt(color.r * 255 * color.a);
-            int g = GRoundToInt(color.g * 255 * color.a);
-            int b = GRoundToInt(color.b * 255 * color.a);
+        blendMode = simplifyBlendMode(blendMode, color.a);
+    }
+    this->noteBlend(blendMode, useShader ? shader->isOpaque() : color.a >= 1.f);
 
-            BlendFunc* blendFunc = getBlendFunc(blendMode);
+    // Terminate if kDst.
+    if (blendMode == GBlendMode::kDst) {
+        return;
+    }
 
-            for (int y = top_pixel; y < bottom_pixel; y++) {
-                std::list<PathEdge>::iterator it;
-                if (k > 0) {
-                    // Sort the first k edges by x
-                    k = sortFirstK(edges, k, y);
-                    // Loop through edges
-                    it = edges.begin();
-                    int w = 0;
-                    int left_pixel, width;
-                    int iMax = k;
-                    for (int i = 0; i < iMax; i++) {
-                        int edge_x = it->row_x;
-                        // If left pixel, instantiate
-                        if (w == 0) {
-                            left_pixel = edge_x;
-                        }
-                        w += it->direction;
-                        // If row segment is over and width > 0, fill.
-                        if (w == 0 && (width = edge_x - left_pixel) > 0) {
-                            // Obtain pixelRow, shaderRow.
-                            GPixel* pixelRow = fDevice.getAddr(left_pixel, y);
-                            for (int j = 0; j < width; j++) {
-                                pixelRow[j] = blendFunc(pixelRow[j], a, r, g, b);
-                            }
-                        }
-                        // If edge is valid, it++; else, remove
-                        if (it->isValid(y+1)) {
-                            it++;
-                        } else {
-                            it = edges.erase(it);
-                            k--;
-                        }
-                    }
-                } else {
-                    it = edges.begin();
-                }
+    // Terminate if the polygon's bounds, outset by the radius and mapped to the device, miss the canvas.
+    float radius = width * 0.5f;
+    GRect bounds = GRect::LTRB(points[0].x, points[0].y, points[0].x, points[0].y);
+    for (int i = 1; i < count; i++) {
+        bounds.left = std::min(bounds.left, points[i].x);
+        bounds.top = std::min(bounds.top, points[i].y);
+        bounds.right = std::max(bounds.right, points[i].x);
+        bounds.bottom = std::max(bounds.bottom, points[i].y);
+    }
+    bounds = GRect::LTRB(bounds.left - radius, bounds.top - radius, bounds.right + radius, bounds.bottom + radius);
+    if (missesDevice(bounds, currentMatrix, fDevice.width(), fTop, fTop + fDevice.height())) {
+        return;
+    }
 
-                // Loop through the remaining elements and increment k as necessary
-                while (it != edges.end()) {
-                    if (it->isValid(y+1)) {
-                        k++;
-                        it++;
-                    } else {
-                        break;
-                    }
-                }
-            }
-        }
+    // The arcs are fit to the largest device length of a unit vector, so they are fine enough in every direction.
+    float scale = std::max(currentMatrix.e0().length(), currentMatrix.e1().length());
+    if (!(scale > 0.f)) {
+        return;
     }
+
+    EdgeStrokeSink sink(currentMatrix, paint.getTolerance(), fHeight, fDevice.width());
+    GStrokeOutline(points, count, width, isClosed, 1.f / scale, &sink);
+    sink.closeContour();
+    fillPathEdges(fDevice, fTop, sink.edges, sink.bottom_pixel, useShader ? shader : nullptr, color, blendMode);
 }
 
 void MyCanvas::drawMesh(const GPoint verts[], const GColor colors[], const GPoint texs[],
@@ -1384,7 +1358,7 @@ void MyCanvas::drawMesh(const GPoint verts[], const GColor colors[], const GPoin
                 texs[ind0], texs[ind1], texs[ind2],
                 bmShader
             );
-            std::shared_ptr<GShader> shader = GCreateTriComposeShader(gradShader.get(), stickShader.get());
+            std::shared_ptr<GShader> shader = GCreateTriComposeShader(gradShader.get(), stickShader.get(), &composeRow);
             GPaint composePaint = GPaint(shader);
     		const GPoint triVerts[] = {verts[ind0], verts[ind1], verts[ind2]};
             drawConvexPolygon(triVerts, 3, composePaint);
@@ -1653,18 +1627,23 @@ std::unique_ptr<GCanvas> GCreateCanvas(const GBitmap& device) {
     return std::unique_ptr<GCanvas>(new MyCanvas(device));
 }
 
+std::unique_ptr<GCanvas> GCreateCanvas(GBitmap* device) {
+    return std::unique_ptr<GCanvas>(new MyCanvas(*device, device));
+}
+
 std::string GDrawSomething(GCanvas* canvas, GISize dim) {
     int width = dim.width;
     int height = dim.height;
 
-    // Add a background.
-    GBitmap background = GBitmap();
-    background.readFromFile("my_background.png");
-    float scaleX = (float) width / background.width();
-    float scaleY = (float) height / background.height();
-    GMatrix fillCanvas = GMatrix::Scale(scaleX, scaleY);
-    std::shared_ptr<GShader> bgShader = GCreateBitmapShader(background, fillCanvas);
-    canvas->drawRect(GRect::LTRB(0, 0, width, height), GPaint(bgShader));
+    // Add a background (decoded once per process, see GImageCache.h).
+    std::shared_ptr<const GBitmap> background = GImageCacheGet("my_background.png");
+    if (background) {
+        float scaleX = (float) width / background->width();
+        float scaleY = (float) height / background->height();
+        GMatrix fillCanvas = GMatrix::Scale(scaleX, scaleY);
+        std::shared_ptr<GShader> bgShader = GCreateBitmapShader(background, fillCanvas);
+        canvas->drawRect(GRect::LTRB(0, 0, width, height), GPaint(bgShader));
+    }
 
     float edge = 0;
     float x1 = 0.25f * width;
@@ -14,10 +14,19 @@
 
 class MyCanvas : public GCanvas {
 public:
-    MyCanvas(const GBitmap& device) : fDevice(device) {
+    // If owner is given, its opaque hint is kept current as draws land (see GCreateCanvas(GBitmap*)).
+    MyCanvas(const GBitmap& device, GBitmap* owner = nullptr)
+        : fDevice(device), fOwner(owner), fIsOpaque(device.isOpaque()), fHeight(device.height()) {
       currentMatrix = GMatrix();
     }
 
+    // A canvas height rows tall, of which band holds only rows [top, top + band.height()). Draws
+    // rasterize exactly as on the full canvas, and only the band's rows are written.
+    MyCanvas(const GBitmap& band, int top, int height) : MyCanvas(band) {
+      fTop = top;
+      fHeight = height;
+    }
+
     void clear(const GColor& color) override;
 
     virtual void drawRect(const GRect&, const GPaint&) override;
@@ -27,6 +36,14 @@ public:
                               int count, const int indices[], const GPaint& paint) override;
     virtual void drawQuad(const GPoint verts[4], const GColor colors[4], const GPoint texs[4],
                               int level, const GPaint&) override;
+    // Flattens the stroke outline straight into device edges, without building a GPath.
+    virtual void drawStrokePolygon(const GPoint[], int count, float width, bool isClosed,
+                                   const GPaint&) override;
+
+    GMatrix getTotalMatrix() const override { return currentMatrix; }
+
+    // True only if every device pixel is known to be opaque, without scanning them.
+    bool isOpaque() const { return fIsOpaque; }
 
     // Managing the stack of Transform Matrices
     virtual void save() override;
@@ -36,10 +53,24 @@ public:
 private:
     // Note: we store a copy of the bitmap
     const GBitmap fDevice;
+    GBitmap* fOwner;
+    bool fIsOpaque;
+    // fDevice holds canvas rows [fTop, fTop + fDevice.height()) of fHeight.
+    int fTop = 0;
+    int fHeight;
+
+    GPixel* getAddr(int x, int y) const { return fDevice.getAddr(x, y - fTop); }
+
+    void setOpaque(bool isOpaque);
+    // Updates fIsOpaque for a draw with the (simplified) blend mode and source opacity.
+    void noteBlend(GBlendMode blendMode, bool srcIsOpaque);
 
     // Add whatever other fields you need
     std::list<GMatrix> savedMatrices;
     GMatrix currentMatrix;
+
+    // Reusable row buffer for shaders that combine two rows (e.g. TriCompose), so they don't need a VLA per row.
+    std::vector<GPixel> composeRow;
 };
 
 #endif